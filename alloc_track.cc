@@ -0,0 +1,164 @@
+#include "alloc_track.hpp"
+
+#if defined(FRUSTUMCAM_TRACK_ALLOC)
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// plain thread_local integers, nothing to construct on the allocation path
+thread_local uint64_t tls_allocs = 0;
+thread_local uint64_t tls_frees = 0;
+thread_local uint64_t tls_bytes = 0;
+
+atomic<uint64_t> total_allocs(0);
+atomic<uint64_t> total_frees(0);
+atomic<uint64_t> total_bytes(0);
+
+// fixed table so recording a scope never allocates, a slot is claimed by its name pointer
+struct Slot {
+    atomic<const char *> name{nullptr};
+    atomic<uint64_t> calls{0};
+    atomic<uint64_t> allocs{0};
+    atomic<uint64_t> frees{0};
+    atomic<uint64_t> bytes{0};
+};
+Slot slots[alloc_track::MAX_SCOPES];
+
+Slot *find_slot(const char *name) {
+    for (auto &slot : slots) {
+        const char *cur = slot.name.load(memory_order_acquire);
+        if (!cur && slot.name.compare_exchange_strong(cur, name, memory_order_acq_rel))
+            return &slot;
+        // the same literal may have several addresses across translation units
+        if (cur == name || strcmp(cur, name) == 0)
+            return &slot;
+    }
+    return nullptr;
+}
+
+inline void count_alloc(size_t size) {
+    tls_allocs++;
+    tls_bytes += size;
+    total_allocs.fetch_add(1, memory_order_relaxed);
+    total_bytes.fetch_add(size, memory_order_relaxed);
+}
+
+inline void count_free(void *p) {
+    if (!p)
+        return;
+    tls_frees++;
+    total_frees.fetch_add(1, memory_order_relaxed);
+}
+} // namespace
+
+namespace alloc_track {
+
+AllocCounts total() {
+    AllocCounts res;
+    res.allocs = total_allocs.load(memory_order_relaxed);
+    res.frees = total_frees.load(memory_order_relaxed);
+    res.bytes = total_bytes.load(memory_order_relaxed);
+    return res;
+}
+
+AllocCounts this_thread() {
+    AllocCounts res;
+    res.allocs = tls_allocs;
+    res.frees = tls_frees;
+    res.bytes = tls_bytes;
+    return res;
+}
+
+int scopes(AllocScopeStats *out, int max) {
+    int n = 0;
+    for (auto &slot : slots) {
+        const char *name = slot.name.load(memory_order_acquire);
+        if (!name)
+            break;
+        if (n < max) {
+            out[n].name = name;
+            out[n].calls = slot.calls.load(memory_order_relaxed);
+            out[n].counts.allocs = slot.allocs.load(memory_order_relaxed);
+            out[n].counts.frees = slot.frees.load(memory_order_relaxed);
+            out[n].counts.bytes = slot.bytes.load(memory_order_relaxed);
+        }
+        n++;
+    }
+    return n;
+}
+} // namespace alloc_track
+
+AllocScope::~AllocScope() {
+    Slot *slot = find_slot(name_);
+    if (!slot)
+        return;
+    slot->calls.fetch_add(1, memory_order_relaxed);
+    slot->allocs.fetch_add(tls_allocs - start_.allocs, memory_order_relaxed);
+    slot->frees.fetch_add(tls_frees - start_.frees, memory_order_relaxed);
+    slot->bytes.fetch_add(tls_bytes - start_.bytes, memory_order_relaxed);
+}
+
+/**********************************************************/
+// global operator new / delete
+/**********************************************************/
+void *operator new(size_t size) {
+    count_alloc(size);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+void *operator new(size_t size, align_val_t align) {
+    count_alloc(size);
+    size_t a = (size_t)align;
+#if defined(_MSC_VER)
+    if (void *p = _aligned_malloc(size ? size : 1, a))
+        return p;
+#else
+    // aligned_alloc wants a multiple of the alignment
+    if (void *p = aligned_alloc(a, (size + a - 1) / a * a))
+        return p;
+#endif
+    throw bad_alloc();
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept {
+    count_alloc(size);
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept {
+    count_free(p);
+    free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+    count_free(p);
+    free(p);
+}
+void operator delete(void *p, align_val_t) noexcept {
+    count_free(p);
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+void operator delete(void *p, size_t, align_val_t align) noexcept {
+    operator delete(p, align);
+}
+void operator delete(void *p, const nothrow_t &) noexcept {
+    count_free(p);
+    free(p);
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef __ALLOC_TRACK_HPP__
+#define __ALLOC_TRACK_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocation tracking, compiled in with -DFRUSTUMCAM_TRACK_ALLOC=ON.
+// The instrumented build replaces the global operator new / delete with counting versions.
+// Process wide totals come from alloc_track::total(), AllocScope attributes the allocations
+// of the calling thread to a name. Without the option everything here is a no-op.
+
+struct AllocCounts {
+    uint64_t allocs = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;
+};
+
+struct AllocScopeStats {
+    const char *name;
+    uint64_t calls;
+    AllocCounts counts;
+};
+
+namespace alloc_track {
+
+// distinct scope names, later names are not recorded
+constexpr int MAX_SCOPES = 32;
+
+#if defined(FRUSTUMCAM_TRACK_ALLOC)
+constexpr bool ENABLED = true;
+
+// all threads since start
+AllocCounts total();
+// calling thread since start
+AllocCounts this_thread();
+// fills at most `max` entries, returns the number of scopes recorded so far
+int scopes(AllocScopeStats *out, int max);
+#else
+constexpr bool ENABLED = false;
+
+inline AllocCounts total() { return AllocCounts(); }
+inline AllocCounts this_thread() { return AllocCounts(); }
+inline int scopes(AllocScopeStats *, int) { return 0; }
+#endif
+} // namespace alloc_track
+
+// Counts the allocations of this thread until it goes out of scope and adds them to the
+// totals of `name`, which must be a string literal. Nested scopes count in both.
+class AllocScope {
+  public:
+#if defined(FRUSTUMCAM_TRACK_ALLOC)
+    explicit AllocScope(const char *name) : name_(name), start_(alloc_track::this_thread()) {}
+    ~AllocScope();
+#else
+    explicit AllocScope(const char *) {}
+#endif
+
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+
+#if defined(FRUSTUMCAM_TRACK_ALLOC)
+  private:
+    const char *name_;
+    AllocCounts start_;
+#endif
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef __ARENA_HPP__
+#define __ARENA_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "span.hpp"
+
+// Linear allocator for transient per-frame data, reset() at the start of every frame.
+// Allocations are a pointer bump in one block. When a frame needs more, the extra requests
+// get blocks of their own and the next reset() grows the main block to the high-water mark,
+// so after the first few frames a steady-state frame does no heap allocation at all.
+// Only trivially destructible types, nothing is destroyed on reset().
+class FrameArena {
+  public:
+    explicit FrameArena(size_t capacity = 0)
+        : capacity_(0), used_(0), overflow_bytes_(0), peak_(0) {
+        if (capacity > 0) {
+            block_.reset(new unsigned char[capacity]);
+            capacity_ = capacity;
+        }
+    }
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+    FrameArena(FrameArena &&) = default;
+    FrameArena &operator=(FrameArena &&) = default;
+
+    // n uninitialized T, valid until the next reset() or until the enclosing Scope ends
+    template <typename T> Span<T> alloc(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "FrameArena never runs destructors");
+        return Span<T>(static_cast<T *>(alloc_bytes(n * sizeof(T), alignof(T))), n);
+    }
+
+    void reset() {
+        overflow_.clear();
+        if (peak_ > capacity_) {
+            // round up so a slowly growing load does not reallocate every frame
+            size_t capacity = std::max(peak_, capacity_ + capacity_ / 2);
+            block_.reset(new unsigned char[capacity]);
+            capacity_ = capacity;
+        }
+        used_ = 0;
+        overflow_bytes_ = 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+    // bytes handed out since reset(), including overflow blocks
+    size_t used() const { return used_ + overflow_bytes_; }
+
+    // releases everything allocated inside it on destruction, e.g. per-item scratch in a loop
+    class Scope {
+      public:
+        explicit Scope(FrameArena &arena)
+            : arena_(arena), used_(arena.used_), overflow_(arena.overflow_.size()),
+              overflow_bytes_(arena.overflow_bytes_) {}
+        ~Scope() {
+            arena_.used_ = used_;
+            arena_.overflow_.resize(overflow_);
+            arena_.overflow_bytes_ = overflow_bytes_;
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        FrameArena &arena_;
+        size_t used_;
+        size_t overflow_;
+        size_t overflow_bytes_;
+    };
+
+  private:
+    void *alloc_bytes(size_t size, size_t align) {
+        size_t offset = (used_ + align - 1) & ~(align - 1);
+        if (offset + size <= capacity_) {
+            used_ = offset + size;
+            peak_ = std::max(peak_, used());
+            return block_.get() + offset;
+        }
+
+        // new[] is aligned for any fundamental type
+        overflow_.emplace_back(new unsigned char[size ? size : 1]);
+        overflow_bytes_ += size + align;
+        peak_ = std::max(peak_, used());
+        return overflow_.back().get();
+    }
+
+  private:
+    std::unique_ptr<unsigned char[]> block_;
+    size_t capacity_;
+    size_t used_;
+    size_t overflow_bytes_;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow_;
+    // largest used() since construction
+    size_t peak_;
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "association.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t NONE = numeric_limits<uint32_t>::max();
+
+uint32_t find_root(vector<uint32_t> &parent, uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+} // namespace
+
+void ProjectedGrid::build(Span<const ProjectedPoint> points, int width, int height, float cell) {
+    cell_ = max(cell, 1.f);
+    cols_ = max(1, (int)ceil(width / cell_));
+    rows_ = max(1, (int)ceil(height / cell_));
+    size_t cells = (size_t)cols_ * rows_;
+
+    // counting sort by cell
+    start_.assign(cells + 1, 0);
+    for (const auto &p : points)
+        if (p.visible)
+            start_[clamp_row(p.win.z / cell_) * cols_ + clamp_col(p.win.x / cell_) + 1]++;
+    for (size_t c = 0; c < cells; c++)
+        start_[c + 1] += start_[c];
+
+    index_.resize(start_[cells]);
+    pos_.resize(start_[cells]);
+    for (uint32_t i = 0; i < points.size(); i++) {
+        const ProjectedPoint &p = points[i];
+        if (!p.visible)
+            continue;
+        uint32_t &slot = start_[clamp_row(p.win.z / cell_) * cols_ + clamp_col(p.win.x / cell_)];
+        index_[slot] = i;
+        pos_[slot] = glm::vec2(p.win.x, p.win.z);
+        slot++;
+    }
+    // the fill advanced every start to the next cell's, shift back
+    for (size_t c = cells; c > 0; c--)
+        start_[c] = start_[c - 1];
+    start_[0] = 0;
+}
+
+void Associator::run(Span<const ProjectedPoint> projected, int width, int height,
+                     Span<const glm::vec2> detections, float radius, Solver solver,
+                     vector<Match> &out) {
+    out.clear();
+    // with cells of one radius every query looks at 3 x 3 cells at most
+    grid_.build(projected, width, height, radius);
+
+    candidates_.clear();
+    for (uint32_t d = 0; d < detections.size(); d++)
+        grid_.query(detections[d], radius, [&](uint32_t point, float dist2) {
+            candidates_.push_back(Candidate{d, point, dist2});
+        });
+
+    if (solver == Solver::Greedy) {
+        det_used_.assign(detections.size(), 0);
+        point_used_.assign(projected.size(), 0);
+        greedy(candidates_, projected, out);
+    } else {
+        optimal(projected, detections.size(), radius, out);
+    }
+
+    sort(out.begin(), out.end(),
+         [](const Match &a, const Match &b) { return a.detection < b.detection; });
+}
+
+void Associator::greedy(Span<Candidate> candidates, Span<const ProjectedPoint> projected,
+                        vector<Match> &out) {
+    // ties broken by index so the result does not depend on the grid order
+    sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        if (a.dist2 != b.dist2)
+            return a.dist2 < b.dist2;
+        return a.detection != b.detection ? a.detection < b.detection : a.point < b.point;
+    });
+    for (const auto &c : candidates) {
+        if (det_used_[c.detection] || point_used_[c.point])
+            continue;
+        det_used_[c.detection] = 1;
+        point_used_[c.point] = 1;
+        out.push_back(Match{(int)c.detection, projected[c.point].id, sqrt(c.dist2)});
+    }
+}
+
+void Associator::optimal(Span<const ProjectedPoint> projected, size_t n_detections, float radius,
+                         vector<Match> &out) {
+    // connected groups of candidates are independent assignment problems
+    size_t n_nodes = n_detections + projected.size();
+    parent_.resize(n_nodes);
+    for (const auto &c : candidates_) {
+        parent_[c.detection] = c.detection;
+        parent_[n_detections + c.point] = (uint32_t)(n_detections + c.point);
+    }
+    for (const auto &c : candidates_) {
+        uint32_t a = find_root(parent_, c.detection);
+        uint32_t b = find_root(parent_, (uint32_t)(n_detections + c.point));
+        if (a != b)
+            parent_[max(a, b)] = min(a, b);
+    }
+    // flatten so parent_ of every detection is its group root
+    for (const auto &c : candidates_)
+        find_root(parent_, c.detection);
+    sort(candidates_.begin(), candidates_.end(), [&](const Candidate &a, const Candidate &b) {
+        uint32_t ra = parent_[a.detection], rb = parent_[b.detection];
+        return ra != rb ? ra < rb : a.detection < b.detection;
+    });
+
+    det_used_.assign(n_detections, 0);
+    point_used_.assign(projected.size(), 0);
+    det_local_.assign(n_detections, NONE);
+    point_local_.assign(projected.size(), NONE);
+
+    for (size_t begin = 0; begin < candidates_.size();) {
+        uint32_t root = parent_[candidates_[begin].detection];
+        size_t end = begin;
+        group_det_.clear();
+        group_point_.clear();
+        for (; end < candidates_.size() && parent_[candidates_[end].detection] == root; end++) {
+            const Candidate &c = candidates_[end];
+            if (det_local_[c.detection] == NONE) {
+                det_local_[c.detection] = (uint32_t)group_det_.size();
+                group_det_.push_back(c.detection);
+            }
+            if (point_local_[c.point] == NONE) {
+                point_local_[c.point] = (uint32_t)group_point_.size();
+                group_point_.push_back(c.point);
+            }
+        }
+
+        size_t nd = group_det_.size(), np = group_point_.size();
+        Span<Candidate> group(candidates_.data() + begin, end - begin);
+        if (nd + np > OPTIMAL_MAX_GROUP) {
+            greedy(group, projected, out);
+        } else if (group.size() == 1) {
+            const Candidate &c = group[0];
+            out.push_back(Match{(int)c.detection, projected[c.point].id, sqrt(c.dist2)});
+        } else {
+            // rows: detections, then one "unmatched" row per point
+            // cols: points, then one "unmatched" column per detection
+            // leaving a detection or point unmatched costs more than any set of matches, so
+            // the most matches win and the distance only decides among those
+            int n = (int)(nd + np);
+            double unmatched = (double)radius * (n + 1);
+            double forbidden = unmatched * (n + 1) * 4;
+            cost_.assign((size_t)n * n, forbidden);
+            for (const auto &c : group)
+                cost_[det_local_[c.detection] * n + point_local_[c.point]] = sqrt(c.dist2);
+            for (size_t d = 0; d < nd; d++)
+                cost_[d * n + np + d] = unmatched;
+            for (size_t p = 0; p < np; p++) {
+                cost_[(nd + p) * n + p] = unmatched;
+                for (size_t d = 0; d < nd; d++)
+                    cost_[(nd + p) * n + np + d] = 0;
+            }
+            hungarian(n);
+
+            for (size_t p = 0; p < np; p++) {
+                int row = match_[p + 1] - 1;
+                if (row < 0 || row >= (int)nd)
+                    continue;
+                double dist = cost_[row * n + p];
+                if (dist >= unmatched)
+                    continue;
+                out.push_back(Match{(int)group_det_[row], projected[group_point_[p]].id,
+                                    (float)dist});
+            }
+        }
+
+        for (uint32_t d : group_det_)
+            det_local_[d] = NONE;
+        for (uint32_t p : group_point_)
+            point_local_[p] = NONE;
+        begin = end;
+    }
+}
+
+void Associator::hungarian(int n) {
+    // potentials / augmenting path form, O(n^3). index 0 is the virtual start column
+    const double inf = numeric_limits<double>::infinity();
+    u_.assign(n + 1, 0);
+    v_.assign(n + 1, 0);
+    match_.assign(n + 1, 0);
+    way_.assign(n + 1, 0);
+
+    for (int i = 1; i <= n; i++) {
+        match_[0] = i;
+        int j0 = 0;
+        min_.assign(n + 1, inf);
+        used_.assign(n + 1, 0);
+        do {
+            used_[j0] = 1;
+            int i0 = match_[j0], j1 = 0;
+            double delta = inf;
+            const double *row = cost_.data() + (size_t)(i0 - 1) * n;
+            for (int j = 1; j <= n; j++) {
+                if (used_[j])
+                    continue;
+                double cur = row[j - 1] - u_[i0] - v_[j];
+                if (cur < min_[j]) {
+                    min_[j] = cur;
+                    way_[j] = j0;
+                }
+                if (min_[j] < delta) {
+                    delta = min_[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= n; j++) {
+                if (used_[j]) {
+                    u_[match_[j]] += delta;
+                    v_[j] -= delta;
+                } else {
+                    min_[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (match_[j0] != 0);
+
+        do {
+            int j1 = way_[j0];
+            match_[j0] = match_[j1];
+            j0 = j1;
+        } while (j0);
+    }
+}
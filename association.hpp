@@ -0,0 +1,118 @@
+#ifndef __ASSOCIATION_HPP__
+#define __ASSOCIATION_HPP__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "projection.hpp"
+#include "span.hpp"
+
+// one detection assigned to the projected object it was matched with
+struct Match {
+    int detection; // index into the detections
+    int obj_id;
+    float distance; // pixels
+};
+
+// Uniform grid over the visible projected points of one camera, bucketed by a counting sort
+// into one flat array per build so rebuilding it every frame does not allocate once warm.
+class ProjectedGrid {
+  public:
+    ProjectedGrid() : cell_(1.f), cols_(0), rows_(0){};
+
+    // visible points only, in square cells of `cell` pixels
+    void build(Span<const ProjectedPoint> points, int width, int height, float cell);
+
+    // fn(index into points, squared distance) for every point within radius of px
+    template <typename F> void query(const glm::vec2 &px, float radius, F &&fn) const {
+        if (cols_ == 0)
+            return;
+        int x0 = clamp_col((px.x - radius) / cell_), x1 = clamp_col((px.x + radius) / cell_);
+        int y0 = clamp_row((px.y - radius) / cell_), y1 = clamp_row((px.y + radius) / cell_);
+        float r2 = radius * radius;
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                int c = y * cols_ + x;
+                for (uint32_t k = start_[c]; k < start_[c + 1]; k++) {
+                    glm::vec2 d = pos_[k] - px;
+                    float dist2 = glm::dot(d, d);
+                    if (dist2 <= r2)
+                        fn(index_[k], dist2);
+                }
+            }
+        }
+    }
+
+  private:
+    int clamp_col(float x) const { return x < 0 ? 0 : x >= cols_ ? cols_ - 1 : (int)x; }
+    int clamp_row(float y) const { return y < 0 ? 0 : y >= rows_ ? rows_ - 1 : (int)y; }
+
+  private:
+    float cell_;
+    int cols_;
+    int rows_;
+    // points of cell c are [start_[c], start_[c + 1]) in index_ / pos_
+    std::vector<uint32_t> start_;
+    std::vector<uint32_t> index_;
+    std::vector<glm::vec2> pos_;
+};
+
+// Matches 2D detections of one camera to the objects projected by projection::run().
+// Detections follow ProjectedPoint: (column, row from the bottom of the image). Only pairs
+// closer than `radius` pixels are candidates, every detection and object is used at most once.
+// Keeps its scratch buffers between calls, use one per thread.
+class Associator {
+  public:
+    enum class Solver {
+        // shortest candidate pairs first
+        Greedy,
+        // least total distance among the assignments with the most matches, per connected
+        // group of candidates (Hungarian method). groups larger than OPTIMAL_MAX_GROUP are
+        // solved greedily
+        Optimal,
+    };
+
+    static constexpr size_t OPTIMAL_MAX_GROUP = 128;
+
+    // matches sorted by detection
+    void run(Span<const ProjectedPoint> projected, int width, int height,
+             Span<const glm::vec2> detections, float radius, Solver solver,
+             std::vector<Match> &out);
+
+  private:
+    struct Candidate {
+        uint32_t detection;
+        uint32_t point;
+        float dist2;
+    };
+
+    // candidates are reordered
+    void greedy(Span<Candidate> candidates, Span<const ProjectedPoint> projected,
+                std::vector<Match> &out);
+    void optimal(Span<const ProjectedPoint> projected, size_t n_detections, float radius,
+                 std::vector<Match> &out);
+    // minimum cost perfect matching of the n x n cost_ matrix into match_
+    void hungarian(int n);
+
+  private:
+    ProjectedGrid grid_;
+    std::vector<Candidate> candidates_;
+    std::vector<uint8_t> det_used_;
+    std::vector<uint8_t> point_used_;
+    // Solver::Optimal: union-find over detections and then points, local indices in a group
+    std::vector<uint32_t> parent_;
+    std::vector<uint32_t> det_local_;
+    std::vector<uint32_t> point_local_;
+    std::vector<uint32_t> group_det_;
+    std::vector<uint32_t> group_point_;
+    // Hungarian method state, row of column j is match_[j], 1-based
+    std::vector<double> cost_;
+    std::vector<double> u_, v_, min_;
+    std::vector<int> match_, way_;
+    std::vector<uint8_t> used_;
+};
+
+#endif
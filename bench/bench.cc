@@ -0,0 +1,589 @@
+// Micro-benchmarks of the camera / projection hot paths over synthetic scenes.
+//
+// usage: frustumcam_bench [--filter <substr>] [--max <n>] [--min-time <sec>] [--json]
+//                         [--assert-zero-alloc]
+//
+// Every benchmark runs for 10, 100, ... up to --max items (default 1M) and reports
+// time per iteration, throughput, heap allocations and, where the kernel allows it,
+// hardware cache misses per iteration.
+// --assert-zero-alloc fails the run when a path that must not touch the heap in steady state
+// (ZERO_ALLOC below) allocated.
+
+#include <glm/glm.hpp>
+
+#include <json/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "alloc_track.hpp"
+#include "association.hpp"
+#include "bvh.hpp"
+#include "calibration.hpp"
+#include "camera.hpp"
+#include "config.hpp"
+#include "controller.hpp"
+#include "geodesy.hpp"
+#include "overlap.hpp"
+#include "projection.hpp"
+#include "synthetic.hpp"
+#include "trajectory.hpp"
+#include "triangulation.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**********************************************************/
+// allocation counting
+/**********************************************************/
+// the bench is always built with alloc_track's counting operator new / delete, see CMakeLists.txt
+namespace {
+AllocCounts alloc_start;
+
+void start_alloc_count() { alloc_start = alloc_track::total(); }
+void stop_alloc_count(uint64_t &count, uint64_t &bytes) {
+    AllocCounts now = alloc_track::total();
+    count = now.allocs - alloc_start.allocs;
+    bytes = now.bytes - alloc_start.bytes;
+}
+} // namespace
+
+namespace {
+
+/**********************************************************/
+// hardware counters
+/**********************************************************/
+class CacheMissCounter {
+  public:
+    CacheMissCounter() : fd_(-1) {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~CacheMissCounter() {
+#if defined(__linux__)
+        if (fd_ >= 0)
+            close(fd_);
+#endif
+    }
+
+    bool available() const { return fd_ >= 0; }
+
+    void start() {
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // -1 when the counter is not available
+    int64_t stop() {
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            int64_t value = 0;
+            if (read(fd_, &value, sizeof(value)) == sizeof(value))
+                return value;
+        }
+#endif
+        return -1;
+    }
+
+  private:
+    int fd_;
+};
+
+template <typename T> inline void keep(const T &value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+/**********************************************************/
+// harness
+/**********************************************************/
+struct Options {
+    string filter;
+    size_t max_n = 1000000;
+    double min_time = 0.2;
+    bool json = false;
+    bool assert_zero_alloc = false;
+};
+
+struct Result {
+    string name;
+    size_t n;
+    uint64_t iters;
+    double ns_per_iter;
+    double items_per_sec;
+    double allocs_per_iter;
+    double bytes_per_iter;
+    double cache_misses_per_iter; // < 0 when not available
+};
+
+Options opts;
+CacheMissCounter cache_misses;
+vector<Result> results;
+
+template <typename F> void measure(const string &name, size_t n, size_t items, F &&fn) {
+    fn(); // warm-up, also lets buffers reach their steady-state capacity
+
+    uint64_t iters = 1;
+    while (true) {
+        start_alloc_count();
+        cache_misses.start();
+        auto t0 = chrono::steady_clock::now();
+
+        for (uint64_t i = 0; i < iters; i++)
+            fn();
+
+        auto t1 = chrono::steady_clock::now();
+        int64_t misses = cache_misses.stop();
+        uint64_t allocs, bytes;
+        stop_alloc_count(allocs, bytes);
+
+        double sec = chrono::duration<double>(t1 - t0).count();
+        if (sec < opts.min_time && iters < (1ull << 30)) {
+            iters = sec <= 0 ? iters * 10
+                             : max<uint64_t>(iters * 2, (uint64_t)(iters * opts.min_time / sec * 1.2));
+            continue;
+        }
+
+        Result res;
+        res.name = name;
+        res.n = n;
+        res.iters = iters;
+        res.ns_per_iter = sec * 1e9 / iters;
+        res.items_per_sec = items * iters / sec;
+        res.allocs_per_iter = (double)allocs / iters;
+        res.bytes_per_iter = (double)bytes / iters;
+        res.cache_misses_per_iter = misses < 0 ? -1 : (double)misses / iters;
+        results.push_back(res);
+
+        if (!opts.json) {
+            char misses_str[32] = "n/a";
+            if (res.cache_misses_per_iter >= 0)
+                snprintf(misses_str, sizeof(misses_str), "%.1f", res.cache_misses_per_iter);
+            printf("%-28s %9zu %10llu %14.1f %14.4g %10.1f %12.1f %12s\n", name.c_str(), n,
+                   (unsigned long long)iters, res.ns_per_iter, res.items_per_sec,
+                   res.allocs_per_iter, res.bytes_per_iter, misses_str);
+            fflush(stdout);
+        }
+        return;
+    }
+}
+
+bool enabled(const string &name) {
+    return opts.filter.empty() || name.find(opts.filter) != string::npos;
+}
+
+vector<size_t> sizes() {
+    vector<size_t> res;
+    for (size_t n = 10; n <= opts.max_n; n *= 10)
+        res.push_back(n);
+    return res;
+}
+
+/**********************************************************/
+// benchmarks
+/**********************************************************/
+void bench_projection_run(size_t n) {
+    float extent = synthetic::site_extent(n);
+    vector<Object> objs = synthetic::make_objects(n, extent);
+    Camera cam = synthetic::make_cameras(1, extent)[0];
+    vector<ProjectedPoint> out(n);
+
+    glm::mat4 mvp = cam.get_mvp();
+    measure("projection::run", n, n, [&] {
+        size_t visible = projection::run(objs, mvp, cam.width_, cam.height_, out);
+        keep(visible);
+    });
+}
+
+void bench_occlude(size_t n) {
+    float extent = synthetic::site_extent(n);
+    vector<Object> objs = synthetic::make_objects(n, extent);
+    Camera cam = synthetic::make_cameras(1, extent)[0];
+    vector<ProjectedPoint> projected(n), out(n);
+    projection::run(objs, cam.get_mvp(), cam.width_, cam.height_, projected);
+
+    Mesh mesh = synthetic::make_buildings(max<size_t>(10, n / 20), extent);
+    Bvh bvh(mesh);
+    measure("occlude", n, n, [&] {
+        out = projected;
+        size_t visible = occlude(bvh, cam.get_pose(), objs, out);
+        keep(visible);
+    });
+
+    measure("Bvh::Bvh", n, mesh.face.size(), [&] {
+        Bvh b(mesh);
+        keep(b);
+    });
+}
+
+void bench_introjection(size_t n) {
+    Camera cam = synthetic::make_cameras(1, 10.f)[0];
+    vector<glm::vec3> px(n), out(n);
+    for (size_t i = 0; i < n; i++)
+        px[i] = glm::vec3(i % cam.width_, (i % 101) / 100.f, (i / cam.width_) % cam.height_);
+
+    glm::mat4 mvp = cam.get_mvp();
+    measure("introjection/batch", n, n, [&] {
+        projection::introjection(Span<const glm::vec3>(px), mvp, cam.width_, cam.height_,
+                                 Span<glm::vec3>(out));
+        keep(out[0]);
+    });
+    measure("introjection/single", n, n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out[i] = projection::introjection(px[i], mvp, cam.width_, cam.height_);
+        keep(out[0]);
+    });
+}
+
+void bench_camera_construct(size_t n) {
+    vector<CameraParams> params = synthetic::make_camera_params(n, synthetic::site_extent(n));
+    vector<Camera> cams;
+    cams.reserve(n);
+
+    measure("Camera::Camera", n, n, [&] {
+        cams.clear();
+        for (const auto &p : params)
+            cams.push_back(Camera(p));
+        keep(cams.back());
+    });
+    measure("Camera::build", n, n, [&] {
+        Camera::build(params, cams);
+        keep(cams.back());
+    });
+}
+
+void bench_camera_get_frustum(size_t n) {
+    vector<Camera> cams = synthetic::make_cameras(n, synthetic::site_extent(n));
+
+    measure("Camera::get_frustum", n, n, [&] {
+        glm::vec3 acc(0);
+        for (const auto &cam : cams)
+            acc += cam.get_frustum()[7];
+        keep(acc);
+    });
+}
+
+void bench_controller_get_world_pos(size_t n) {
+    Controller control;
+
+    measure("Controller::get_world_pos", n, n, [&] {
+        glm::vec3 acc(0);
+        for (size_t i = 0; i < n; i++)
+            acc += control.get_world_pos((float)(i % WIDTH), (float)((i / WIDTH) % HEIGHT));
+        keep(acc);
+    });
+}
+
+void bench_config_load(size_t n) {
+    // UTM-like absolute positions, as found in a real cam.json
+    const glm::dvec3 utm(399323.452068413, 4033846.90068065, 211.174);
+    json j = json::array();
+    for (const auto &p : synthetic::make_camera_params(n, synthetic::site_extent(n))) {
+        j.push_back({{"cam-id", p.id},
+                     {"xyz", {utm.x + p.pos.x, utm.y - p.pos.z, utm.z + p.pos.y}},
+                     {"pry", {p.pry.x, p.pry.y, p.pry.z}},
+                     {"fov", p.fov},
+                     {"width", synthetic::WIDTH},
+                     {"height", synthetic::HEIGHT},
+                     {"near", 1},
+                     {"far", 50}});
+    }
+    filesystem::path file = filesystem::temp_directory_path() / "frustumcam_bench_cam.json";
+    ofstream(file) << j.dump();
+    j = json();
+
+    measure("read_cam_config", n, n, [&] {
+        glm::dvec3 offset;
+        vector<Camera> cams = read_cam_config(file.string(), offset);
+        keep(cams.back());
+    });
+    filesystem::remove(file);
+}
+
+void bench_geodesy(size_t n) {
+    // a national deployment, about 500 km across
+    mt19937 rng(5);
+    uniform_real_distribution<double> lat(34.0, 38.5), lon(126.0, 130.0), height(0.0, 500.0);
+    vector<glm::dvec3> llh(n), enu(n);
+    for (auto &p : llh)
+        p = glm::dvec3(lat(rng), lon(rng), height(rng));
+    geodesy::LocalFrame frame(glm::dvec3(36.0, 128.0, 0.0));
+
+    measure("LocalFrame::llh_to_enu", n, n, [&] {
+        frame.llh_to_enu(llh, enu);
+        keep(enu[0]);
+    });
+}
+
+void bench_association(size_t n) {
+    // n objects below one camera looking straight down, one detection each with a few pixels
+    // of noise
+    float extent = synthetic::site_extent(n);
+    CameraParams param;
+    param.id = 1;
+    param.pos = glm::vec3(0, extent, 0);
+    param.pry = glm::vec3(90, 0, 0);
+    param.fov = 90;
+    param.width = synthetic::WIDTH;
+    param.height = synthetic::HEIGHT;
+    param.near = 1;
+    param.far = 2.f * extent;
+    Camera cam(param);
+
+    vector<Object> objs = synthetic::make_objects(n, extent);
+    vector<ProjectedPoint> projected(n);
+    projection::run(objs, cam.get_mvp(), cam.width_, cam.height_, projected);
+
+    mt19937 rng(6);
+    normal_distribution<float> noise(0.f, 3.f);
+    vector<glm::vec2> detections;
+    for (const auto &p : projected)
+        if (p.visible)
+            detections.push_back(glm::vec2(p.win.x + noise(rng), p.win.z + noise(rng)));
+
+    Associator assoc;
+    vector<Match> matches;
+    for (auto solver : {Associator::Solver::Greedy, Associator::Solver::Optimal}) {
+        const char *name = solver == Associator::Solver::Greedy ? "Associator::run/greedy"
+                                                                : "Associator::run/optimal";
+        measure(name, n, detections.size(), [&] {
+            assoc.run(projected, cam.width_, cam.height_, detections, 10.f, solver, matches);
+            keep(matches);
+        });
+    }
+}
+
+void bench_calibration(size_t n) {
+    // 30 targets in view of each of n cameras, observed with pixel noise by slightly wrong
+    // cameras: about a metre off, a few degrees of rotation and fov
+    float extent = synthetic::site_extent(n);
+    vector<Camera> truth = synthetic::make_cameras(n, extent);
+    mt19937 rng(7);
+    normal_distribution<float> noise(0.f, 0.5f), meter(0.f, 1.f), degree(0.f, 2.f);
+    uniform_real_distribution<float> unit(0.f, 1.f);
+
+    Correspondences corr;
+    vector<CameraParams> params(n);
+    for (size_t c = 0; c < n; c++) {
+        const Camera &cam = truth[c];
+        glm::mat4 inv_mvp = glm::inverse(cam.get_mvp());
+        for (int k = 0; k < 30; k++) {
+            glm::vec3 px(unit(rng) * cam.width_, 0.f, unit(rng) * cam.height_);
+            glm::vec3 o = projection::unproject(px, inv_mvp, cam.width_, cam.height_);
+            px.y = 1.f;
+            glm::vec3 e = projection::unproject(px, inv_mvp, cam.width_, cam.height_);
+            glm::vec3 world = o + (e - o) * (0.1f + 0.7f * unit(rng));
+            corr.push((int)c, world, glm::vec2(px.x + noise(rng), px.z + noise(rng)));
+        }
+        params[c] = cam.get_params();
+        params[c].pos += glm::vec3(meter(rng), meter(rng), meter(rng));
+        params[c].pry += glm::vec3(degree(rng), degree(rng), degree(rng));
+        params[c].fov += degree(rng);
+    }
+
+    Scheduler scheduler;
+    calibration::Options opt;
+    vector<Camera> cams;
+    measure("calibration::run", n, n, [&] {
+        Camera::build(params, cams);
+        vector<calibration::Result> res = calibration::run(cams, corr, opt, scheduler);
+        keep(res);
+    });
+}
+
+void bench_overlap(size_t n) {
+    vector<Camera> cams = synthetic::make_cameras(n, synthetic::site_extent(n));
+    Scheduler scheduler;
+
+    measure("overlap::run", n, n, [&] {
+        OverlapMatrix mat = overlap::run(cams, scheduler);
+        keep(mat);
+    });
+}
+
+void bench_triangulation(size_t n) {
+    // every target is observed by the cameras that see it, about 10 on average
+    float extent = 10.f;
+    vector<Camera> cams = synthetic::make_cameras(64, extent);
+    vector<Object> objs = synthetic::make_objects(n, extent);
+    vector<ProjectedPoint> projected(n);
+
+    Observations obs;
+    for (size_t c = 0; c < cams.size(); c++) {
+        projection::run(objs, cams[c].get_mvp(), cams[c].width_, cams[c].height_, projected);
+        for (const auto &p : projected)
+            if (p.visible)
+                obs.push(p.id, (int)c, glm::vec2(p.win.x, p.win.z));
+    }
+
+    vector<triangulation::View> views = triangulation::views(cams);
+    Scheduler scheduler;
+    measure("triangulation::run", n, n, [&] {
+        vector<Triangulated> res = triangulation::run(views, obs, scheduler);
+        keep(res);
+    });
+}
+
+void bench_trajectory_sample(size_t n) {
+    // n tracks of 100 samples each, spread over a one hour recording
+    mt19937 rng(4);
+    uniform_real_distribution<double> start(0, 3600), len(60, 600);
+    vector<int> ids;
+    vector<double> times;
+    vector<glm::vec3> pos;
+    for (size_t i = 0; i < n; i++) {
+        double t0 = start(rng), dt = len(rng) / 99;
+        for (int k = 0; k < 100; k++) {
+            ids.push_back((int)i);
+            times.push_back(t0 + k * dt);
+            pos.push_back(glm::vec3(k, 0, i));
+        }
+    }
+    Trajectories traj(ids, times, pos);
+    vector<Object> out;
+    out.reserve(n);
+
+    double t = 0;
+    measure("Trajectories::sample", n, n, [&] {
+        t = t + 7.3 > 3600 ? 0 : t + 7.3;
+        size_t alive = traj.sample(t, out);
+        keep(alive);
+    });
+}
+
+struct Bench {
+    const char *name;
+    void (*run)(size_t n);
+    size_t max_n; // 0: no cap besides --max
+};
+
+const Bench benches[] = {
+    {"projection::run", bench_projection_run, 0},
+    {"occlude", bench_occlude, 0},
+    {"introjection", bench_introjection, 0},
+    {"Camera::Camera", bench_camera_construct, 0},
+    {"Camera::get_frustum", bench_camera_get_frustum, 0},
+    {"Controller::get_world_pos", bench_controller_get_world_pos, 0},
+    {"read_cam_config", bench_config_load, 0},
+    {"LocalFrame::llh_to_enu", bench_geodesy, 0},
+    {"triangulation::run", bench_triangulation, 0},
+    // a camera seldom sees more than a few thousand targets
+    {"Associator::run", bench_association, 10000},
+    {"calibration::run", bench_calibration, 10000},
+    {"Trajectories::sample", bench_trajectory_sample, 100000},
+    // candidate pairs grow with site density, keep the default run short
+    {"overlap::run", bench_overlap, 10000},
+};
+
+// hot paths that run every frame and must reuse their buffers once warm
+const char *const ZERO_ALLOC[] = {
+    "projection::run", "occlude", "introjection/batch", "Camera::get_frustum",
+    "Controller::get_world_pos", "Trajectories::sample", "LocalFrame::llh_to_enu",
+    "Associator::run/greedy", "Associator::run/optimal",
+};
+} // namespace
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+            opts.filter = argv[++i];
+        else if (arg == "--max" && i + 1 < argc)
+            opts.max_n = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--min-time" && i + 1 < argc)
+            opts.min_time = atof(argv[++i]);
+        else if (arg == "--json")
+            opts.json = true;
+        else if (arg == "--assert-zero-alloc")
+            opts.assert_zero_alloc = true;
+        else {
+            cerr << "usage: " << argv[0]
+                 << " [--filter <substr>] [--max <n>] [--min-time <sec>] [--json]"
+                    " [--assert-zero-alloc]"
+                 << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!opts.json) {
+        printf("%-28s %9s %10s %14s %14s %10s %12s %12s\n", "benchmark", "n", "iters", "ns/iter",
+               "items/s", "allocs", "bytes", "cache-miss");
+        if (!cache_misses.available())
+            printf("(hardware cache counters not available)\n");
+    }
+
+    for (const auto &bench : benches) {
+        if (!enabled(bench.name))
+            continue;
+        for (size_t n : sizes())
+            if (bench.max_n == 0 || n <= bench.max_n)
+                bench.run(n);
+    }
+
+    if (opts.json) {
+        json out = json::array();
+        for (const auto &res : results) {
+            json r = {{"name", res.name},
+                      {"n", res.n},
+                      {"iterations", res.iters},
+                      {"ns_per_iter", res.ns_per_iter},
+                      {"items_per_sec", res.items_per_sec},
+                      {"allocs_per_iter", res.allocs_per_iter},
+                      {"bytes_per_iter", res.bytes_per_iter}};
+            r["cache_misses_per_iter"] =
+                res.cache_misses_per_iter < 0 ? json(nullptr) : json(res.cache_misses_per_iter);
+            out.push_back(r);
+        }
+        cout << out.dump(2) << endl;
+    }
+
+    if (opts.assert_zero_alloc) {
+        bool failed = false;
+        for (const auto &res : results) {
+            for (const char *name : ZERO_ALLOC) {
+                if (res.name == name && res.allocs_per_iter > 0) {
+                    cerr << "allocation in " << res.name << " (n = " << res.n
+                         << "): " << res.allocs_per_iter << " allocs / iter" << endl;
+                    failed = true;
+                }
+            }
+        }
+        if (failed)
+            return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
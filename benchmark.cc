@@ -0,0 +1,169 @@
+#include "benchmark.hpp"
+
+#include "alloc_track.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace {
+
+json stats(vector<double> ms) {
+    if (ms.empty())
+        return json();
+
+    sort(ms.begin(), ms.end());
+    // nearest rank
+    auto percentile = [&](double p) {
+        size_t rank = (size_t)ceil(p / 100.0 * ms.size());
+        return ms[min(ms.size(), max<size_t>(rank, 1)) - 1];
+    };
+    double sum = 0;
+    for (double v : ms)
+        sum += v;
+
+    json res;
+    res["mean"] = sum / ms.size();
+    res["p50"] = percentile(50);
+    res["p95"] = percentile(95);
+    res["p99"] = percentile(99);
+    res["max"] = ms.back();
+    return res;
+}
+
+// in KiB, -1 when unknown
+long peak_rss_kib() {
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+#endif
+    return -1;
+}
+} // namespace
+
+FrameBenchmark::FrameBenchmark(size_t frames)
+    : frames_(frames), seen_(0), recorded_(0), allocs_start_(0), allocs_(0),
+      bytes_start_(0), query_next_(0) {
+    frame_ms_.reserve(frames);
+    gpu_ms_.reserve(frames);
+    frame_allocs_.reserve(frames);
+    frame_bytes_.reserve(frames);
+    glGenQueries(BENCHMARK_QUERIES, query_);
+    fill(query_pending_, query_pending_ + BENCHMARK_QUERIES, false);
+    fill(query_recorded_, query_recorded_ + BENCHMARK_QUERIES, false);
+}
+
+FrameBenchmark::~FrameBenchmark() { glDeleteQueries(BENCHMARK_QUERIES, query_); }
+
+void FrameBenchmark::collect(int query) {
+    if (!query_pending_[query])
+        return;
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(query_[query], GL_QUERY_RESULT, &ns);
+    if (query_recorded_[query])
+        gpu_ms_.push_back(ns * 1e-6);
+    query_pending_[query] = false;
+}
+
+void FrameBenchmark::begin_frame() {
+    // the slot was started BENCHMARK_QUERIES frames ago, normally finished by now
+    collect(query_next_);
+    glBeginQuery(GL_TIME_ELAPSED, query_[query_next_]);
+
+    AllocCounts counts = alloc_track::total();
+    allocs_start_ = counts.allocs;
+    bytes_start_ = counts.bytes;
+
+    frame_start_ = Clock::now();
+    mark_ = frame_start_;
+}
+
+void FrameBenchmark::stage(const char *name) {
+    Clock::time_point now = Clock::now();
+    double ms = chrono::duration<double, milli>(now - mark_).count();
+    mark_ = now;
+
+    // stages are registered during warm-up, recorded frames only append to reserved storage
+    size_t i = find(stage_name_.begin(), stage_name_.end(), name) - stage_name_.begin();
+    if (i == stage_name_.size()) {
+        stage_name_.push_back(name);
+        stage_ms_.emplace_back();
+        stage_ms_.back().reserve(frames_);
+    }
+    if (seen_ >= BENCHMARK_WARMUP)
+        stage_ms_[i].push_back(ms);
+}
+
+void FrameBenchmark::end_frame() {
+    glEndQuery(GL_TIME_ELAPSED);
+    bool record = seen_ >= BENCHMARK_WARMUP;
+    query_pending_[query_next_] = true;
+    query_recorded_[query_next_] = record;
+    query_next_ = (query_next_ + 1) % BENCHMARK_QUERIES;
+
+    if (record) {
+        frame_ms_.push_back(chrono::duration<double, milli>(Clock::now() - frame_start_).count());
+        recorded_++;
+
+        AllocCounts counts = alloc_track::total();
+        frame_allocs_.push_back((double)(counts.allocs - allocs_start_));
+        frame_bytes_.push_back((double)(counts.bytes - bytes_start_));
+        allocs_ += counts.allocs - allocs_start_;
+    }
+    seen_++;
+}
+
+json FrameBenchmark::summary() {
+    for (int q = 0; q < BENCHMARK_QUERIES; q++)
+        collect(q);
+
+    double total_ms = 0;
+    for (double v : frame_ms_)
+        total_ms += v;
+
+    json res;
+    res["frames"] = frame_ms_.size();
+    res["warmup_frames"] = BENCHMARK_WARMUP;
+    res["fps"] = total_ms > 0 ? frame_ms_.size() * 1000.0 / total_ms : 0.0;
+    res["frame_ms"] = stats(frame_ms_);
+    res["gpu_ms"] = stats(gpu_ms_);
+
+    json stages = json::object();
+    for (size_t i = 0; i < stage_name_.size(); i++)
+        stages[stage_name_[i]] = stats(stage_ms_[i]);
+    res["stage_ms"] = stages;
+
+    res["peak_rss_kib"] = peak_rss_kib();
+
+    if (alloc_track::ENABLED) {
+        res["allocs_per_frame"] = stats(frame_allocs_);
+        res["alloc_bytes_per_frame"] = stats(frame_bytes_);
+
+        AllocScopeStats scopes[alloc_track::MAX_SCOPES];
+        int n = min(alloc_track::scopes(scopes, alloc_track::MAX_SCOPES), alloc_track::MAX_SCOPES);
+        json per_scope = json::object();
+        for (int i = 0; i < n; i++)
+            per_scope[scopes[i].name] = {{"calls", scopes[i].calls},
+                                         {"allocs", scopes[i].counts.allocs},
+                                         {"frees", scopes[i].counts.frees},
+                                         {"bytes", scopes[i].counts.bytes}};
+        res["alloc_scopes"] = per_scope;
+    }
+
+    const GLubyte *renderer = glGetString(GL_RENDERER);
+    const GLubyte *version = glGetString(GL_VERSION);
+    res["renderer"] = renderer ? (const char *)renderer : "";
+    res["gl_version"] = version ? (const char *)version : "";
+    return res;
+}
@@ -0,0 +1,71 @@
+#ifndef __BENCHMARK_HPP__
+#define __BENCHMARK_HPP__
+
+#include <GL/glew.h>
+#include <json/json.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// frames rendered before recording starts, shaders and buffers settle in these
+constexpr size_t BENCHMARK_WARMUP = 10;
+// GL_TIME_ELAPSED queries in flight, results are read this many frames later
+constexpr int BENCHMARK_QUERIES = 4;
+
+// Frame pacing statistics of the viewer loop for --benchmark.
+// Every frame is cut into named CPU stages with stage(), GPU time of the whole frame comes
+// from timer queries that are collected a few frames late so they never stall the loop.
+class FrameBenchmark {
+  public:
+    explicit FrameBenchmark(size_t frames);
+    ~FrameBenchmark();
+
+    bool done() const { return recorded_ >= frames_; }
+
+    void begin_frame();
+    // CPU time since the previous mark is accounted to `name`, stages keep their first order
+    void stage(const char *name);
+    // call after the buffer swap
+    void end_frame();
+
+    // frame, stage and GPU times in ms as mean / p50 / p95 / p99 / max, plus peak memory.
+    // the FRUSTUMCAM_TRACK_ALLOC build adds heap allocations per frame and per AllocScope
+    nlohmann::json summary();
+    // heap allocations of the recorded frames, all threads. 0 without FRUSTUMCAM_TRACK_ALLOC
+    uint64_t allocs() const { return allocs_; }
+
+  private:
+    void collect(int query);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    size_t frames_;
+    size_t seen_;
+    size_t recorded_;
+
+    Clock::time_point frame_start_;
+    Clock::time_point mark_;
+
+    std::vector<double> frame_ms_;
+    std::vector<std::string> stage_name_;
+    std::vector<std::vector<double>> stage_ms_;
+    std::vector<double> gpu_ms_;
+
+    uint64_t allocs_start_;
+    std::vector<double> frame_allocs_;
+    std::vector<double> frame_bytes_;
+    uint64_t allocs_;
+    uint64_t bytes_start_;
+
+    GLuint query_[BENCHMARK_QUERIES];
+    // the query slot is running or waiting to be read, and whether that frame is recorded
+    bool query_pending_[BENCHMARK_QUERIES];
+    bool query_recorded_[BENCHMARK_QUERIES];
+    int query_next_;
+};
+
+#endif
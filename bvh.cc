@@ -0,0 +1,279 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+constexpr int SAH_BINS = 12;
+constexpr int MIN_LEAF = 2;
+constexpr int MAX_LEAF = 8;
+constexpr int MAX_DEPTH = 64;
+
+// segment parameters closer than this to either end do not count as hits, so objects sitting on
+// a surface are not hidden by it
+constexpr float T_EPS = 1e-4f;
+
+// screen tile size used to group coherent segments into packets
+constexpr int PACKET_TILE = 32;
+
+float area(const glm::vec3 &lo, const glm::vec3 &hi) {
+    glm::vec3 d = glm::max(hi - lo, glm::vec3(0));
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+inline bool hit_box(const glm::vec3 &lo, const glm::vec3 &hi, const glm::vec3 &from,
+                    const glm::vec3 &inv_dir) {
+    glm::vec3 t0 = (lo - from) * inv_dir;
+    glm::vec3 t1 = (hi - from) * inv_dir;
+    glm::vec3 t_near = glm::min(t0, t1), t_far = glm::max(t0, t1);
+    float enter = max(max(t_near.x, t_near.y), max(t_near.z, 0.f));
+    float exit = min(min(t_far.x, t_far.y), min(t_far.z, 1.f));
+    return enter <= exit;
+}
+
+// Moller-Trumbore, segment from + t * dir for t in (0, 1)
+inline bool hit_triangle(const glm::vec3 &v0, const glm::vec3 &e1, const glm::vec3 &e2,
+                         const glm::vec3 &from, const glm::vec3 &dir) {
+    glm::vec3 p = glm::cross(dir, e2);
+    float det = glm::dot(e1, p);
+    if (fabs(det) < 1e-12f)
+        return false;
+    float inv_det = 1.f / det;
+
+    glm::vec3 s = from - v0;
+    float u = glm::dot(s, p) * inv_det;
+    if (u < 0.f || u > 1.f)
+        return false;
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(dir, q) * inv_det;
+    if (v < 0.f || u + v > 1.f)
+        return false;
+    float t = glm::dot(e2, q) * inv_det;
+    return t > T_EPS && t < 1.f - T_EPS;
+}
+} // namespace
+
+Bvh::Bvh(const Mesh &mesh) {
+    int n = (int)mesh.face.size();
+    if (n == 0)
+        return;
+
+    vector<glm::vec3> lo(n), hi(n);
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) {
+        const glm::ivec3 &f = mesh.face[i];
+        lo[i] = glm::min(glm::min(mesh.vertex[f.x], mesh.vertex[f.y]), mesh.vertex[f.z]);
+        hi[i] = glm::max(glm::max(mesh.vertex[f.x], mesh.vertex[f.y]), mesh.vertex[f.z]);
+        order[i] = i;
+    }
+
+    nodes_.reserve(2 * n);
+    nodes_.push_back(Node());
+    split(0, order, lo, hi, 0, n, 0);
+
+    // triangles in leaf order, stored as one vertex and two edges
+    tris_.resize(n);
+    for (int i = 0; i < n; i++) {
+        const glm::ivec3 &f = mesh.face[order[i]];
+        glm::vec3 v0 = mesh.vertex[f.x];
+        tris_[i] = Triangle{v0, mesh.vertex[f.y] - v0, mesh.vertex[f.z] - v0};
+    }
+}
+
+void Bvh::split(int node, vector<int> &order, const vector<glm::vec3> &lo,
+                const vector<glm::vec3> &hi, int begin, int end, int depth) {
+    glm::vec3 box_lo(numeric_limits<float>::max()), box_hi(-numeric_limits<float>::max());
+    glm::vec3 c_lo = box_lo, c_hi = box_hi;
+    for (int i = begin; i < end; i++) {
+        int t = order[i];
+        box_lo = glm::min(box_lo, lo[t]);
+        box_hi = glm::max(box_hi, hi[t]);
+        glm::vec3 c = (lo[t] + hi[t]) * 0.5f;
+        c_lo = glm::min(c_lo, c);
+        c_hi = glm::max(c_hi, c);
+    }
+    nodes_[node].min = box_lo;
+    nodes_[node].max = box_hi;
+    nodes_[node].first = begin;
+    nodes_[node].count = end - begin;
+
+    int count = end - begin;
+    if (count <= MIN_LEAF || depth >= MAX_DEPTH)
+        return;
+
+    glm::vec3 extent = c_hi - c_lo;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    if (extent[axis] <= 0.f)
+        return;
+
+    // bin centroids along the widest axis and sweep the SAH cost of every bin boundary
+    int bin_count[SAH_BINS] = {};
+    glm::vec3 bin_lo[SAH_BINS], bin_hi[SAH_BINS];
+    fill(bin_lo, bin_lo + SAH_BINS, glm::vec3(numeric_limits<float>::max()));
+    fill(bin_hi, bin_hi + SAH_BINS, glm::vec3(-numeric_limits<float>::max()));
+    float scale = SAH_BINS / extent[axis];
+    auto bin_of = [&](int t) {
+        float c = (lo[t][axis] + hi[t][axis]) * 0.5f;
+        return min(SAH_BINS - 1, (int)((c - c_lo[axis]) * scale));
+    };
+    for (int i = begin; i < end; i++) {
+        int t = order[i], b = bin_of(t);
+        bin_count[b]++;
+        bin_lo[b] = glm::min(bin_lo[b], lo[t]);
+        bin_hi[b] = glm::max(bin_hi[b], hi[t]);
+    }
+
+    float right_area[SAH_BINS];
+    int right_count[SAH_BINS];
+    glm::vec3 acc_lo(numeric_limits<float>::max()), acc_hi(-numeric_limits<float>::max());
+    int acc = 0;
+    for (int b = SAH_BINS - 1; b > 0; b--) {
+        acc += bin_count[b];
+        acc_lo = glm::min(acc_lo, bin_lo[b]);
+        acc_hi = glm::max(acc_hi, bin_hi[b]);
+        right_area[b] = area(acc_lo, acc_hi);
+        right_count[b] = acc;
+    }
+
+    float best_cost = numeric_limits<float>::max();
+    int best = -1;
+    acc_lo = glm::vec3(numeric_limits<float>::max());
+    acc_hi = glm::vec3(-numeric_limits<float>::max());
+    acc = 0;
+    for (int b = 1; b < SAH_BINS; b++) {
+        acc += bin_count[b - 1];
+        acc_lo = glm::min(acc_lo, bin_lo[b - 1]);
+        acc_hi = glm::max(acc_hi, bin_hi[b - 1]);
+        if (acc == 0 || right_count[b] == 0)
+            continue;
+        float cost = acc * area(acc_lo, acc_hi) + right_count[b] * right_area[b];
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = b;
+        }
+    }
+
+    // a leaf is cheaper than any split
+    if (best < 0 || (count <= MAX_LEAF && best_cost >= count * area(box_lo, box_hi)))
+        return;
+
+    int mid = (int)(partition(order.begin() + begin, order.begin() + end,
+                              [&](int t) { return bin_of(t) < best; }) -
+                    order.begin());
+
+    int left = (int)nodes_.size();
+    nodes_.push_back(Node());
+    nodes_.push_back(Node());
+    nodes_[node].first = left;
+    nodes_[node].count = 0;
+    split(left, order, lo, hi, begin, mid, depth + 1);
+    split(left + 1, order, lo, hi, mid, end, depth + 1);
+}
+
+bool Bvh::occluded(const glm::vec3 &from, const glm::vec3 &to) const {
+    uint8_t res = 0;
+    if (!empty())
+        packet(from, &to, 1, &res);
+    return res != 0;
+}
+
+void Bvh::occluded(const glm::vec3 &from, Span<const glm::vec3> to, Span<uint8_t> out) const {
+    assert(out.size() >= to.size());
+    if (empty()) {
+        fill(out.begin(), out.begin() + to.size(), 0);
+        return;
+    }
+    for (size_t i = 0; i < to.size(); i += BVH_PACKET)
+        packet(from, &to[i], (int)min<size_t>(BVH_PACKET, to.size() - i), &out[i]);
+}
+
+void Bvh::packet(const glm::vec3 &from, const glm::vec3 *to, int n, uint8_t *out) const {
+    static_assert(BVH_PACKET < 32, "packet masks are 32 bit");
+
+    glm::vec3 dir[BVH_PACKET], inv_dir[BVH_PACKET];
+    for (int i = 0; i < n; i++) {
+        dir[i] = to[i] - from;
+        inv_dir[i] = 1.f / dir[i];
+    }
+
+    // segments not hit yet
+    uint32_t open = (1u << n) - 1;
+
+    // every stack entry carries the segments that reached its parent
+    struct Entry {
+        int node;
+        uint32_t mask;
+    } stack[MAX_DEPTH + 2];
+    int sp = 0;
+    stack[sp++] = Entry{0, open};
+
+    while (sp > 0 && open) {
+        Entry e = stack[--sp];
+        const Node &node = nodes_[e.node];
+
+        uint32_t mask = 0, live = e.mask & open;
+        for (int i = 0; i < n; i++)
+            if ((live >> i & 1) && hit_box(node.min, node.max, from, inv_dir[i]))
+                mask |= 1u << i;
+        if (!mask)
+            continue;
+
+        if (node.count == 0) {
+            stack[sp++] = Entry{node.first + 1, mask};
+            stack[sp++] = Entry{node.first, mask};
+            continue;
+        }
+
+        uint32_t hit = 0;
+        for (int t = node.first; t < node.first + node.count && hit != mask; t++) {
+            const Triangle &tri = tris_[t];
+            for (int i = 0; i < n; i++)
+                if (((mask & ~hit) >> i & 1) && hit_triangle(tri.v0, tri.e1, tri.e2, from, dir[i]))
+                    hit |= 1u << i;
+        }
+        open &= ~hit;
+    }
+
+    for (int i = 0; i < n; i++)
+        out[i] = (open >> i & 1) ? 0 : 1;
+}
+
+size_t occlude(const Bvh &bvh, const glm::vec3 &eye, Span<const Object> objects,
+               Span<ProjectedPoint> points) {
+    // visible objects sorted by screen tile, so every packet looks in nearly one direction
+    thread_local vector<uint64_t> keys;
+    thread_local vector<glm::vec3> targets;
+    thread_local vector<uint8_t> hidden;
+
+    keys.clear();
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!points[i].visible)
+            continue;
+        uint64_t tx = (uint64_t)max(0.f, points[i].win.x) / PACKET_TILE;
+        uint64_t ty = (uint64_t)max(0.f, points[i].win.z) / PACKET_TILE;
+        keys.push_back((ty << 48) | (tx << 32) | i);
+    }
+    if (bvh.empty())
+        return keys.size();
+    sort(keys.begin(), keys.end());
+
+    targets.resize(keys.size());
+    hidden.resize(keys.size());
+    for (size_t k = 0; k < keys.size(); k++)
+        targets[k] = objects[keys[k] & 0xffffffffu].pt;
+    bvh.occluded(eye, targets, hidden);
+
+    size_t visible = 0;
+    for (size_t k = 0; k < keys.size(); k++) {
+        if (hidden[k])
+            points[keys[k] & 0xffffffffu].visible = false;
+        else
+            visible++;
+    }
+    return visible;
+}
@@ -0,0 +1,60 @@
+#ifndef __BVH_HPP__
+#define __BVH_HPP__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+#include "projection.hpp"
+#include "span.hpp"
+
+// segments traced together by the packet query
+constexpr int BVH_PACKET = 16;
+
+// Bounding volume hierarchy over the triangles of a Mesh (binned SAH build) for any-hit
+// segment queries.
+class Bvh {
+  public:
+    Bvh(){};
+    explicit Bvh(const Mesh &mesh);
+
+    bool empty() const { return nodes_.empty(); }
+    size_t triangles() const { return tris_.size(); }
+
+    // true if a triangle cuts the segment between `from` and `to` (both ends excluded)
+    bool occluded(const glm::vec3 &from, const glm::vec3 &to) const;
+    // packet version for segments sharing `from`, out[i] belongs to to[i].
+    // segments are traced BVH_PACKET at a time, so neighbouring targets should be close in
+    // direction from `from`
+    void occluded(const glm::vec3 &from, Span<const glm::vec3> to, Span<uint8_t> out) const;
+
+  private:
+    // interior nodes (count == 0) have their children at first and first + 1
+    struct Node {
+        glm::vec3 min;
+        int first;
+        glm::vec3 max;
+        int count;
+    };
+    struct Triangle {
+        glm::vec3 v0, e1, e2;
+    };
+
+    void split(int node, std::vector<int> &order, const std::vector<glm::vec3> &lo,
+               const std::vector<glm::vec3> &hi, int begin, int end, int depth);
+    void packet(const glm::vec3 &from, const glm::vec3 *to, int n, uint8_t *out) const;
+
+  private:
+    std::vector<Node> nodes_;
+    std::vector<Triangle> tris_;
+};
+
+// clear `visible` of every projected object hidden behind the occluders as seen from `eye`.
+// returns the number of objects still visible
+size_t occlude(const Bvh &bvh, const glm::vec3 &eye, Span<const Object> objects,
+               Span<ProjectedPoint> points);
+
+#endif
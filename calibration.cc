@@ -0,0 +1,271 @@
+#include "calibration.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+namespace calibration {
+
+namespace {
+
+constexpr double DEG = 3.14159265358979323846 / 180.0;
+// fov is kept inside (MIN_FOV, MAX_FOV) degrees, steps leaving it are rejected
+constexpr double MIN_FOV = 1.0;
+constexpr double MAX_FOV = 179.0;
+// points closer to the image plane than this (camera space) count as behind the camera
+constexpr double MIN_DEPTH = 1e-6;
+
+// camera parameters in double, in PARAMS order
+struct State {
+    double p[PARAMS];
+};
+
+State state_of(const Camera &cam) {
+    CameraParams params = cam.get_params();
+    return State{{params.pos.x, params.pos.y, params.pos.z, params.pry.x, params.pry.y,
+                  params.pry.z, params.fov}};
+}
+
+// rotation by `angle` radians about a unit axis and its derivative
+glm::dmat3 axis_rotation(double angle, const glm::dvec3 &axis) {
+    return glm::dmat3(glm::rotate(glm::dmat4(1.0), angle, axis));
+}
+
+// cross product with axis as a matrix, d/da axis_rotation(a) = skew(axis) * axis_rotation(a)
+glm::dmat3 skew(const glm::dvec3 &axis) {
+    return glm::dmat3(glm::cross(axis, glm::dvec3(1, 0, 0)), glm::cross(axis, glm::dvec3(0, 1, 0)),
+                      glm::cross(axis, glm::dvec3(0, 0, 1)));
+}
+
+// everything about one state that does not depend on the point
+struct Model {
+    glm::dmat3 rot;
+    // d rot / d pitch, roll, yaw per degree
+    glm::dmat3 d_rot[3];
+    glm::dvec3 pos;
+    glm::dvec2 center;
+    double focal;   // pixels
+    double d_focal; // per degree of fov
+
+    Model(const State &s, int width, int height) {
+        // Camera::orientation(): Rz(roll) * Rx(pitch) * Ry(yaw)
+        const glm::dvec3 x(1, 0, 0), z(0, 0, 1), y(0, 1, 0);
+        glm::dmat3 rx = axis_rotation(s.p[3] * DEG, x);
+        glm::dmat3 rz = axis_rotation(s.p[4] * DEG, z);
+        glm::dmat3 ry = axis_rotation(s.p[5] * DEG, y);
+        rot = rz * rx * ry;
+        d_rot[0] = rz * skew(x) * rx * ry * DEG;
+        d_rot[1] = skew(z) * rot * DEG;
+        d_rot[2] = rot * skew(y) * DEG;
+
+        // cam.json positions have northing along +z, the scene along -z
+        pos = glm::dvec3(s.p[0], s.p[1], -s.p[2]);
+
+        // glm::perspective with aspect = width / height, mapped to the viewport
+        double half = s.p[6] * DEG * 0.5;
+        center = glm::dvec2(width, height) * 0.5;
+        focal = height * 0.5 / tan(half);
+        d_focal = -height * 0.5 / (sin(half) * sin(half)) * 0.5 * DEG;
+    }
+
+    bool project(const glm::dvec3 &world, glm::dvec2 &px, glm::dvec2 (*jacobian)[PARAMS]) const {
+        glm::dvec3 c = rot * (world - pos);
+        if (c.z > -MIN_DEPTH)
+            return false;
+        double inv = -1.0 / c.z;
+        glm::dvec2 uv(c.x * inv, c.y * inv);
+        px = center + focal * uv;
+        if (!jacobian)
+            return true;
+
+        // d px / d c, one row per pixel axis
+        glm::dvec3 du = focal * glm::dvec3(inv, 0, uv.x * inv);
+        glm::dvec3 dv = focal * glm::dvec3(0, inv, uv.y * inv);
+        glm::dvec2(&j)[PARAMS] = *jacobian;
+
+        // d c / d pos is -rot with the sign of z flipped
+        for (int k = 0; k < 3; k++) {
+            glm::dvec3 dc = k == 2 ? rot[k] : -rot[k];
+            j[k] = glm::dvec2(glm::dot(du, dc), glm::dot(dv, dc));
+        }
+        glm::dvec3 rel = world - pos;
+        for (int k = 0; k < 3; k++) {
+            glm::dvec3 dc = d_rot[k] * rel;
+            j[3 + k] = glm::dvec2(glm::dot(du, dc), glm::dot(dv, dc));
+        }
+        j[6] = d_focal * uv;
+        return true;
+    }
+};
+
+// squared reprojection error of a camera's points, infinite if one is behind the camera.
+// with `jtj` / `jtr` also accumulates the normal equations
+double evaluate(const State &s, int width, int height, const Correspondences &corr,
+                const uint32_t *idx, int n, double (*jtj)[PARAMS][PARAMS],
+                double (*jtr)[PARAMS]) {
+    if (s.p[6] <= MIN_FOV || s.p[6] >= MAX_FOV)
+        return INFINITY;
+
+    Model model(s, width, height);
+    if (jtj) {
+        fill(&(*jtj)[0][0], &(*jtj)[0][0] + PARAMS * PARAMS, 0.0);
+        fill(*jtr, *jtr + PARAMS, 0.0);
+    }
+
+    double sq = 0;
+    glm::dvec2 j[PARAMS];
+    for (int k = 0; k < n; k++) {
+        uint32_t i = idx[k];
+        glm::dvec2 px;
+        if (!model.project(glm::dvec3(corr.world[i]), px, jtj ? &j : nullptr))
+            return INFINITY;
+        glm::dvec2 r = px - glm::dvec2(corr.px[i]);
+        sq += glm::dot(r, r);
+        if (!jtj)
+            continue;
+
+        for (int a = 0; a < PARAMS; a++) {
+            (*jtr)[a] += glm::dot(j[a], r);
+            for (int b = 0; b <= a; b++)
+                (*jtj)[a][b] += glm::dot(j[a], j[b]);
+        }
+    }
+    return sq;
+}
+
+// solves the m x m symmetric positive definite system a x = b in place (Cholesky, lower
+// triangle of a). false if a is not positive definite
+bool cholesky_solve(double (&a)[PARAMS][PARAMS], double (&b)[PARAMS], int m) {
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j <= i; j++) {
+            double sum = a[i][j];
+            for (int k = 0; k < j; k++)
+                sum -= a[i][k] * a[j][k];
+            if (i == j) {
+                if (sum <= 0)
+                    return false;
+                a[i][i] = sqrt(sum);
+            } else {
+                a[i][j] = sum / a[j][j];
+            }
+        }
+    }
+    for (int i = 0; i < m; i++) {
+        for (int k = 0; k < i; k++)
+            b[i] -= a[i][k] * b[k];
+        b[i] /= a[i][i];
+    }
+    for (int i = m - 1; i >= 0; i--) {
+        for (int k = i + 1; k < m; k++)
+            b[i] -= a[k][i] * b[k];
+        b[i] /= a[i][i];
+    }
+    return true;
+}
+
+Result solve(Camera &cam, const Correspondences &corr, const uint32_t *idx, int n,
+             const Options &opt) {
+    Result res{n, 0, NAN, NAN, false};
+
+    // indices of the refined parameters
+    int active[PARAMS], m = 0;
+    for (int a = 0; a < PARAMS; a++)
+        if (a < 3 ? opt.position : a < 6 ? opt.orientation : opt.fov)
+            active[m++] = a;
+
+    State s = state_of(cam);
+    double jtj[PARAMS][PARAMS], jtr[PARAMS];
+    double cost = evaluate(s, cam.width_, cam.height_, corr, idx, n, &jtj, &jtr);
+    if (n == 0 || !isfinite(cost))
+        return res;
+    res.rms_before = res.rms_after = (float)sqrt(cost / n);
+    // two residuals per point
+    if (m == 0 || 2 * n < m)
+        return res;
+
+    double lambda = 1e-3;
+    for (res.iterations = 0; res.iterations < opt.max_iterations; res.iterations++) {
+        // retry with stronger damping until a step lowers the cost
+        bool improved = false;
+        double new_cost = cost;
+        State next = s;
+        while (lambda < 1e12) {
+            double a[PARAMS][PARAMS], b[PARAMS];
+            for (int r = 0; r < m; r++) {
+                for (int c = 0; c <= r; c++)
+                    a[r][c] = jtj[active[r]][active[c]];
+                a[r][r] += lambda * a[r][r] + 1e-12;
+                b[r] = -jtr[active[r]];
+            }
+            if (cholesky_solve(a, b, m)) {
+                next = s;
+                for (int r = 0; r < m; r++)
+                    next.p[active[r]] += b[r];
+                new_cost = evaluate(next, cam.width_, cam.height_, corr, idx, n, nullptr, nullptr);
+                if (new_cost < cost) {
+                    improved = true;
+                    break;
+                }
+            }
+            lambda *= 10;
+        }
+        if (!improved)
+            break;
+
+        double gain = cost - new_cost;
+        s = next;
+        cost = evaluate(s, cam.width_, cam.height_, corr, idx, n, &jtj, &jtr);
+        lambda = max(lambda * 0.1, 1e-9);
+        if (gain <= 1e-12 * cost + 1e-18)
+            break;
+    }
+
+    res.rms_after = (float)sqrt(cost / n);
+    res.valid = true;
+    cam.set_pose(glm::vec3(s.p[0], s.p[1], s.p[2]), glm::vec3(s.p[3], s.p[4], s.p[5]));
+    cam.set_intrinsics((float)s.p[6], cam.width_, cam.height_, cam.near_, cam.far_);
+    return res;
+}
+} // namespace
+
+bool project(const Camera &cam, const glm::vec3 &world, glm::vec2 &px,
+             glm::vec2 (&jacobian)[PARAMS]) {
+    Model model(state_of(cam), cam.width_, cam.height_);
+    glm::dvec2 p, j[PARAMS];
+    if (!model.project(glm::dvec3(world), p, &j))
+        return false;
+    px = glm::vec2(p);
+    for (int a = 0; a < PARAMS; a++)
+        jacobian[a] = glm::vec2(j[a]);
+    return true;
+}
+
+vector<Result> run(Span<Camera> cams, const Correspondences &corr, const Options &opt,
+                   Scheduler &scheduler, size_t grain) {
+    assert(corr.world.size() == corr.size() && corr.px.size() == corr.size());
+
+    // group correspondences by camera, counting sort
+    vector<uint32_t> first(cams.size() + 1, 0);
+    for (int c : corr.camera) {
+        assert(c >= 0 && (size_t)c < cams.size());
+        first[c + 1]++;
+    }
+    for (size_t c = 0; c < cams.size(); c++)
+        first[c + 1] += first[c];
+    vector<uint32_t> order(corr.size());
+    vector<uint32_t> fill_pos(first.begin(), first.end() - 1);
+    for (uint32_t i = 0; i < corr.size(); i++)
+        order[fill_pos[corr.camera[i]]++] = i;
+
+    vector<Result> res(cams.size());
+    scheduler.parallel_for(0, cams.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++)
+            res[c] = solve(cams[c], corr, order.data() + first[c],
+                           (int)(first[c + 1] - first[c]), opt);
+    });
+    return res;
+}
+} // namespace calibration
@@ -0,0 +1,70 @@
+#ifndef __CALIBRATION_HPP__
+#define __CALIBRATION_HPP__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "camera.hpp"
+#include "scheduler.hpp"
+#include "span.hpp"
+
+// Known world points and the pixels they were observed at, one entry per (camera, point) in
+// structure-of-arrays form and in any order.
+// camera is an index into the camera list, world is a scene position like Object::pt and px
+// follows introjection(): (column, row from the bottom of the image).
+struct Correspondences {
+    std::vector<int> camera;
+    std::vector<glm::vec3> world;
+    std::vector<glm::vec2> px;
+
+    size_t size() const { return camera.size(); }
+    void clear() {
+        camera.clear();
+        world.clear();
+        px.clear();
+    }
+    void push(int camera_idx, const glm::vec3 &point, const glm::vec2 &pixel) {
+        camera.push_back(camera_idx);
+        world.push_back(point);
+        px.push_back(pixel);
+    }
+};
+
+namespace calibration {
+
+// parameters of a camera, in this order: position (3), pitch / roll / yaw (3), fov (1)
+constexpr int PARAMS = 7;
+
+struct Options {
+    // which parameters are refined, the others keep their value
+    bool position = true;
+    bool orientation = true;
+    bool fov = true;
+    int max_iterations = 100;
+};
+
+struct Result {
+    int points;
+    int iterations;
+    // rms reprojection error in pixels
+    float rms_before;
+    float rms_after;
+    // false when a camera has too few points or some point lies behind it, it is left as is
+    bool valid;
+};
+
+// pixel of a world point and its derivatives by PARAMS (position in scene units, angles and
+// fov in degrees). false for points behind the camera
+bool project(const Camera &cam, const glm::vec3 &world, glm::vec2 &px,
+             glm::vec2 (&jacobian)[PARAMS]);
+
+// Levenberg-Marquardt refinement of every camera with correspondences, in place. Each camera
+// is an independent 7 parameter problem, solved as tasks of `grain` cameras on the scheduler.
+// res[i] belongs to cams[i]
+std::vector<Result> run(Span<Camera> cams, const Correspondences &corr, const Options &opt,
+                        Scheduler &scheduler, size_t grain = 4);
+} // namespace calibration
+
+#endif
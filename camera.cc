@@ -0,0 +1,153 @@
+#include "camera.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+// cameras per batch step in Camera::build
+constexpr size_t BUILD_BLOCK = 64;
+
+std::atomic<uint64_t> last_revision(0);
+} // namespace
+
+Camera::Camera(const int &id, const glm::vec3 pos, const glm::vec3 pry, const float &fov,
+               const float &w, const float &h, const float &near, const float &far)
+    : id_(id), pos_(pos), width_(w), height_(h), far_(far), near_(near) {
+    pos_.z = -pos_.z;
+    rot_ = orientation(pry);
+
+    mat_proj_ = glm::perspective(glm::radians(fov), w / h, near, far);
+    update_view();
+}
+
+void Camera::build(Span<const CameraParams> params, std::vector<Camera> &out) {
+    out.resize(params.size());
+
+    // half angle sines / cosines and the focal scale, one flat array per term so the loops
+    // below stay branch free and vectorizable
+    float sp[BUILD_BLOCK], cp[BUILD_BLOCK], sr[BUILD_BLOCK], cr[BUILD_BLOCK];
+    float sy[BUILD_BLOCK], cy[BUILD_BLOCK], focal[BUILD_BLOCK];
+
+    for (size_t base = 0; base < params.size(); base += BUILD_BLOCK) {
+        size_t n = std::min(BUILD_BLOCK, params.size() - base);
+        const CameraParams *p = params.data() + base;
+
+        for (size_t i = 0; i < n; i++) {
+            glm::vec3 half = glm::radians(p[i].pry) * 0.5f;
+            sp[i] = std::sin(half.x);
+            cp[i] = std::cos(half.x);
+            sr[i] = std::sin(half.y);
+            cr[i] = std::cos(half.y);
+            sy[i] = std::sin(half.z);
+            cy[i] = std::cos(half.z);
+            focal[i] = 1.f / std::tan(glm::radians(p[i].fov) * 0.5f);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            Camera &cam = out[base + i];
+            cam.id_ = p[i].id;
+            cam.width_ = p[i].width;
+            cam.height_ = p[i].height;
+            cam.near_ = p[i].near;
+            cam.far_ = p[i].far;
+            cam.pos_ = glm::vec3(p[i].pos.x, p[i].pos.y, -p[i].pos.z);
+            cam.ground_ = 0.f;
+
+            // Rz(roll) * Rx(pitch) * Ry(yaw) expanded
+            cam.rot_ = glm::quat(cr[i] * cp[i] * cy[i] - sr[i] * sp[i] * sy[i],
+                                 cr[i] * sp[i] * cy[i] - sr[i] * cp[i] * sy[i],
+                                 cr[i] * cp[i] * sy[i] + sr[i] * sp[i] * cy[i],
+                                 sr[i] * cp[i] * cy[i] + cr[i] * sp[i] * sy[i]);
+
+            // glm::perspective
+            float aspect = (float)p[i].width / (float)p[i].height;
+            float depth = p[i].far - p[i].near;
+            glm::mat4 proj(0.f);
+            proj[0][0] = focal[i] / aspect;
+            proj[1][1] = focal[i];
+            proj[2][2] = -(p[i].far + p[i].near) / depth;
+            proj[2][3] = -1.f;
+            proj[3][2] = -2.f * p[i].far * p[i].near / depth;
+            cam.mat_proj_ = proj;
+
+            cam.update_view();
+        }
+    }
+}
+
+glm::quat Camera::orientation(const glm::vec3 &pry) {
+    return glm::angleAxis(glm::radians(pry.y), glm::vec3(0, 0, 1)) *
+           glm::angleAxis(glm::radians(pry.x), glm::vec3(1, 0, 0)) *
+           glm::angleAxis(glm::radians(pry.z), glm::vec3(0, 1, 0));
+}
+
+glm::vec3 Camera::get_pry() const { return pry(rot_); }
+
+glm::vec3 Camera::pry(const glm::quat &rot) {
+    glm::mat3 m = glm::mat3_cast(rot);
+    float pitch = std::asin(glm::clamp(m[1][2], -1.f, 1.f));
+    float roll = std::atan2(-m[1][0], m[1][1]);
+    float yaw = std::atan2(-m[0][2], m[2][2]);
+    return glm::degrees(glm::vec3(pitch, roll, yaw));
+}
+
+float Camera::get_fov() const { return glm::degrees(2.f * std::atan(1.f / mat_proj_[1][1])); }
+
+CameraParams Camera::get_params() const {
+    return CameraParams{id_, glm::vec3(pos_.x, pos_.y, -pos_.z), get_pry(), get_fov(),
+                        width_, height_, near_, far_};
+}
+
+void Camera::set_pose(const glm::vec3 pos, const glm::vec3 pry) {
+    pos_ = glm::vec3(pos.x, pos.y, -pos.z);
+    rot_ = orientation(pry);
+    update_view();
+}
+
+void Camera::set_orientation(const glm::quat &rot) {
+    rot_ = rot;
+    update_view();
+}
+
+void Camera::set_intrinsics(float fov, int w, int h, float near, float far) {
+    width_ = w;
+    height_ = h;
+    near_ = near;
+    far_ = far;
+    mat_proj_ = glm::perspective(glm::radians(fov), (float)w / (float)h, near, far);
+    update_geometry();
+}
+
+void Camera::set_ground(float ground) {
+    ground_ = ground;
+    footprint_ = ground_footprint(frustum_, ground_);
+    revision_ = ++last_revision;
+}
+
+void Camera::update_view() {
+    // world to camera: rotate about the camera position
+    glm::mat3 r = glm::mat3_cast(rot_);
+    mat_view_ = glm::mat4(r);
+    mat_view_[3] = glm::vec4(-(r * pos_), 1.f);
+
+    update_geometry();
+}
+
+void Camera::update_geometry() {
+    // the view is a rigid motion and the projection a symmetric perspective, so the corners
+    // follow from the half extents of the image plane without inverting the mvp:
+    // camera space (+-d / proj[0][0], +-d / proj[1][1], -d) at d = near / far
+    glm::mat3 cam_to_world = glm::transpose(glm::mat3(mat_view_));
+    glm::vec2 half(1.f / mat_proj_[0][0], 1.f / mat_proj_[1][1]);
+    for (int i = 0; i < 8; i++) {
+        float d = i < 4 ? near_ : far_;
+        glm::vec3 p((i & 1 ? d : -d) * half.x, (i & 2 ? d : -d) * half.y, -d);
+        frustum_[i] = cam_to_world * p + pos_;
+    }
+
+    planes_ = frustum_planes(frustum_);
+    bounds_ = frustum_bounds(frustum_);
+    footprint_ = ground_footprint(frustum_, ground_);
+    revision_ = ++last_revision;
+}
@@ -1,79 +1,80 @@
 #ifndef __CAMERA_HPP__
 #define __CAMERA_HPP__
 
-#include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/transform.hpp>
 
+#include <cstdint>
 #include <vector>
 
+#include "footprint.hpp"
+#include "frustum.hpp"
+#include "span.hpp"
+
+// Constructor arguments of one camera, as read from cam.json
+struct CameraParams {
+    int id;
+    glm::vec3 pos;
+    glm::vec3 pry;
+    float fov;
+    int width;
+    int height;
+    float near;
+    float far;
+};
+
 class Camera {
   public:
     Camera(){};
     Camera(const int &id, const glm::vec3 pos, const glm::vec3 pry, const float &fov,
-           const float &w, const float &h, const float &near, const float &far)
-        : id_(id), pos_(pos), pry_(pry), width_(w), height_(h), far_(far), near_(near) {
-        pos_.z = -pos_.z;
-
-        calc_front(5);
+           const float &w, const float &h, const float &near, const float &far);
+    explicit Camera(const CameraParams &p)
+        : Camera(p.id, p.pos, p.pry, p.fov, (float)p.width, (float)p.height, p.near, p.far){};
 
-        mat_view_ = glm::lookAt(pos_, tar_, glm::vec3(0, 1, 0));
-        mat_view_ = glm::rotate(glm::radians(pry_.x), glm::vec3(1, 0, 0)) * mat_view_;
+    // construct every camera in one pass, the trigonometry of all poses is evaluated together
+    static void build(Span<const CameraParams> params, std::vector<Camera> &out);
 
-        mat_proj_ = glm::perspective(glm::radians(fov), w / h, near, far);
-    };
+    // world to camera rotation for pitch / roll / yaw in degrees:
+    // Rz(roll) * Rx(pitch) * Ry(yaw), yaw turning clockwise seen from above
+    static glm::quat orientation(const glm::vec3 &pry);
+    // pitch / roll / yaw in degrees of a world to camera rotation, the inverse of orientation()
+    static glm::vec3 pry(const glm::quat &rot);
 
+    int get_id() const { return id_; };
     glm::mat4 get_mvp() const { return mat_proj_ * mat_view_; };
-    std::vector<GLfloat> get_pose() const { return std::vector<GLfloat>{pos_.x, pos_.y, pos_.z}; };
-    std::vector<GLfloat> get_frustum() const {
-        // reference :
-        // https://gamedev.stackexchange.com/questions/183196/calculating-directional-shadow-map-using-camera-frustum
-
-        std::vector<glm::vec4> clip{glm::vec4(-1, -1, -1, 1), glm::vec4(1, -1, -1, 1),
-                                    glm::vec4(-1, 1, -1, 1),  glm::vec4(1, 1, -1, 1),
-                                    glm::vec4(-1, -1, 1, 1),  glm::vec4(1, -1, 1, 1),
-                                    glm::vec4(-1, 1, 1, 1),   glm::vec4(1, 1, 1, 1)};
-
-        glm::mat4 inv_mvp = glm::inverse(mat_proj_ * mat_view_);
-
-        std::vector<glm::vec4> pt_worlds;
-        for (size_t i = 0; i < clip.size(); i++) {
-            glm::vec4 pt_world = inv_mvp * clip[i];
-            pt_world /= pt_world[3];
-            pt_worlds.push_back(pt_world);
-        }
-
-        int line_indices[12][2] = {
-            {0, 1}, {0, 2}, {0, 4}, {1, 3}, {1, 5}, {2, 3},
-            {2, 6}, {3, 7}, {4, 5}, {4, 6}, {5, 7}, {6, 7},
-        };
-        std::vector<GLfloat> frustum_data;
-        for (int i = 0; i < 12; i++) {
-            std::vector<GLfloat> line{pt_worlds[line_indices[i][0]].x,
-                                      pt_worlds[line_indices[i][0]].y,
-                                      pt_worlds[line_indices[i][0]].z,
-                                      0,
-                                      1.f,
-                                      0,
-                                      pt_worlds[line_indices[i][1]].x,
-                                      pt_worlds[line_indices[i][1]].y,
-                                      pt_worlds[line_indices[i][1]].z,
-                                      0,
-                                      1.f,
-                                      0};
-            frustum_data.insert(frustum_data.end(), line.begin(), line.end());
-        }
-        return frustum_data;
-    }
+    glm::vec3 get_pose() const { return pos_; };
+    glm::quat get_orientation() const { return rot_; };
+    // pitch / roll / yaw in degrees, recovered from the orientation
+    glm::vec3 get_pry() const;
+    // vertical field of view in degrees
+    float get_fov() const;
+    // constructor arguments that rebuild this camera, e.g. to write it back to cam.json
+    CameraParams get_params() const;
+
+    // frustum geometry and the ground footprint are cached, they are recomputed only when the
+    // pose, the intrinsics or the ground change
+    const Frustum &get_frustum() const { return frustum_; };
+    const FrustumPlanes &get_planes() const { return planes_; };
+    const Aabb &get_bounds() const { return bounds_; };
+    const Footprint &get_footprint() const { return footprint_; };
+    float get_ground() const { return ground_; };
+
+    // changes with every update of the cached geometry and is unique across all cameras, so a
+    // consumer can keep derived data until the revision it was built from goes stale
+    uint64_t get_revision() const { return revision_; };
+
+    // pos and pry as in the constructor
+    void set_pose(const glm::vec3 pos, const glm::vec3 pry);
+    // PTZ style updates: keep the position and replace or compose the orientation
+    void set_orientation(const glm::quat &rot);
+    void rotate(const glm::quat &delta) { set_orientation(glm::normalize(delta * rot_)); };
+    void set_intrinsics(float fov, int w, int h, float near, float far);
+    void set_ground(float ground);
 
   private:
-    void calc_front(const double &distance) {
-        // reference --> https://slideplayer.com/slide/16393785/
-        double x = -distance * sin(glm::radians(-pry_.z));
-        double z = distance * cos(glm::radians(-pry_.z));
-
-        tar_ = glm::vec3(pos_.x + x, pos_.y, pos_.z - z);
-    };
+    void update_view();
+    void update_geometry();
 
   public:
     int width_;
@@ -86,11 +87,18 @@ class Camera {
     int id_;
 
     glm::vec3 pos_;
-    glm::vec3 tar_;
-    glm::vec3 pry_;
+    glm::quat rot_;
 
     glm::mat4 mat_view_;
     glm::mat4 mat_proj_;
+
+    float ground_ = 0.f;
+
+    Frustum frustum_;
+    FrustumPlanes planes_;
+    Aabb bounds_;
+    Footprint footprint_;
+    uint64_t revision_ = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,238 @@
+#include "config.hpp"
+
+#include <json/json.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace {
+
+// position of every entry as (easting, northing, height), or as (east, north, up) of `frame`
+// when they are given in llh. geodetic tells which one, mixing both is an error. llh, if
+// given, receives the positions as read
+vector<glm::dvec3> read_positions(const json &entries, bool geodetic,
+                                  const geodesy::LocalFrame &frame,
+                                  vector<glm::dvec3> *llh = nullptr) {
+    vector<glm::dvec3> pos;
+    pos.reserve(entries.size());
+    for (auto &j : entries) {
+        if (j.contains("llh") != geodetic) {
+            cerr << "config mixes xyz and llh positions!" << endl;
+            exit(EXIT_FAILURE);
+        }
+        const json &p = geodetic ? j["llh"] : j["xyz"];
+        pos.push_back(glm::dvec3(p[0], p[1], p[2]));
+    }
+    if (!geodetic)
+        return pos;
+
+    vector<glm::dvec3> enu(pos.size());
+    frame.llh_to_enu(pos, enu);
+    if (llh)
+        llh->swap(pos);
+    return enu;
+}
+
+// scene world position of a camera frame's origin, rounded as the camera was when it was read
+glm::vec3 origin_world(const GeoFrame &geo, const geodesy::LocalFrame &local,
+                       const glm::dvec3 &offset) {
+    return utm_to_world(geo.enu.ecef_to_enu(local.origin_ecef()), offset);
+}
+
+// llh of a scene world position near camera i. the offset from the camera's own frame keeps
+// the double precision of its origin, cameras without one go through the scene frame
+glm::dvec3 camera_llh(const GeoFrame &geo, size_t i, const glm::vec3 &world,
+                      const glm::dvec3 &offset) {
+    if (i >= geo.local.size())
+        return world_to_llh(world, offset, geo);
+    const geodesy::LocalFrame &local = geo.local[i];
+    glm::vec3 d = world - origin_world(geo, local, offset);
+    glm::dvec3 enu = geo.enu.rotation_to(local) * glm::dvec3(d.x, -d.z, d.y);
+    return local.enu_to_llh(enu);
+}
+} // namespace
+
+glm::mat3 local_to_scene(const GeoFrame &geo, const geodesy::LocalFrame &local) {
+    // world axes are (east, up, -north), glm is column major
+    const glm::dmat3 axes(1, 0, 0, 0, 0, -1, 0, 1, 0);
+    return glm::mat3(axes * local.rotation_to(geo.enu) * glm::transpose(axes));
+}
+
+vector<Camera> read_cam_config(const std::string &file, glm::dvec3 &offset, GeoFrame *geo) {
+    ifstream file_handler(file);
+    if (!file_handler.is_open()) {
+        cerr << "reading config json fail!" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    string json_data;
+    std::ostringstream json_oss;
+    json_oss << file_handler.rdbuf();
+    json_data = json_oss.str();
+    file_handler.close();
+
+    json entries = json::parse(json_data);
+
+    // a geodetic scene is placed in the tangent plane at the first camera, on the ellipsoid so
+    // that up stays close to the ellipsoidal height
+    GeoFrame frame;
+    frame.geodetic = !entries.empty() && entries[0].contains("llh");
+    if (frame.geodetic) {
+        const json &origin = entries[0]["llh"];
+        frame.enu = geodesy::LocalFrame(glm::dvec3(origin[0], origin[1], 0.0));
+    }
+    vector<glm::dvec3> llh;
+    vector<glm::dvec3> pos = read_positions(entries, frame.geodetic, frame.enu, &llh);
+
+    if (!pos.empty())
+        offset = glm::dvec3(pos[0].x, pos[0].z, pos[0].y);
+
+    vector<CameraParams> params;
+    params.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        const json &j = entries[i];
+        glm::dvec3 xyz(pos[i].x, pos[i].z, pos[i].y);
+        glm::vec3 pry(j["pry"][0], j["pry"][1], j["pry"][2]);
+        params.push_back(CameraParams{j["cam-id"], glm::vec3(xyz - offset), pry, j["fov"],
+                                      j["width"], j["height"], j["near"], j["far"]});
+    }
+
+    vector<Camera> res;
+    Camera::build(params, res);
+
+    // pry is relative to the camera's own east / north / up, which tilts away from the
+    // scene's with the distance to the first camera
+    if (frame.geodetic) {
+        frame.local.reserve(res.size());
+        for (size_t i = 0; i < res.size(); i++) {
+            frame.local.emplace_back(llh[i]);
+            glm::mat3 to_local = glm::transpose(local_to_scene(frame, frame.local[i]));
+            res[i].set_orientation(res[i].get_orientation() * glm::quat_cast(to_local));
+        }
+    }
+    if (geo)
+        *geo = frame;
+    return res;
+}
+
+vector<Object> read_obj_config(const std::string &file, const glm::dvec3 &offset,
+                               const GeoFrame *geo) {
+    ifstream file_handler(file);
+    if (!file_handler.is_open()) {
+        cerr << "reading config json fail!" << endl;
+        exit(EXIT_FAILURE);
+    }
+    string json_data;
+    std::ostringstream json_oss;
+    json_oss << file_handler.rdbuf();
+    json_data = json_oss.str();
+    file_handler.close();
+
+    json entries = json::parse(json_data);
+    bool geodetic = geo && geo->geodetic;
+    if (!geodetic && !entries.empty() && entries[0].contains("llh")) {
+        cerr << "objects in llh need a cam.json in llh!" << endl;
+        exit(EXIT_FAILURE);
+    }
+    vector<glm::dvec3> pos =
+        read_positions(entries, geodetic, geodetic ? geo->enu : geodesy::LocalFrame());
+
+    vector<Object> res;
+    res.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        glm::dvec3 xyz(pos[i].x, pos[i].z, pos[i].y);
+        res.push_back(Object(entries[i]["obj-id"], glm::vec3(xyz - offset)));
+    }
+    return res;
+}
+
+void write_cam_config(const std::string &file, const vector<Camera> &cams,
+                      const glm::dvec3 &offset, const GeoFrame *geo) {
+    bool geodetic = geo && geo->geodetic;
+    json j = json::array();
+    for (size_t i = 0; i < cams.size(); i++) {
+        const Camera &cam = cams[i];
+        CameraParams p = cam.get_params();
+        glm::vec3 world = cam.get_pose();
+        glm::dvec3 pos;
+        if (geodetic) {
+            // pry back into the frame at the position written
+            pos = camera_llh(*geo, i, world, offset);
+            glm::mat3 to_scene = local_to_scene(*geo, geodesy::LocalFrame(pos));
+            p.pry = Camera::pry(cam.get_orientation() * glm::quat_cast(to_scene));
+        } else {
+            pos = world_to_utm(world, offset);
+        }
+        j.push_back({{"cam-id", p.id},
+                     {geodetic ? "llh" : "xyz", {pos.x, pos.y, pos.z}},
+                     {"pry", {p.pry.x, p.pry.y, p.pry.z}},
+                     {"fov", p.fov},
+                     {"width", p.width},
+                     {"height", p.height},
+                     {"near", p.near},
+                     {"far", p.far}});
+    }
+
+    if (file == "-") {
+        cout << j.dump(2) << endl;
+        return;
+    }
+    ofstream file_handler(file);
+    if (!file_handler.is_open()) {
+        cerr << "writing config json fail!" << endl;
+        exit(EXIT_FAILURE);
+    }
+    file_handler << j.dump(2) << endl;
+}
+
+void write_footprints(const std::string &file, const vector<Camera> &cams,
+                      const glm::dvec3 &offset, const GeoFrame *geo) {
+    bool geodetic = geo && geo->geodetic;
+    json j = json::array();
+    for (size_t c = 0; c < cams.size(); c++) {
+        const Camera &cam = cams[c];
+        json polygon = json::array();
+        if (geodetic) {
+            // cut with the plane at the ground height in the camera's own frame, the scene's
+            // horizontal drops away from it with the distance to the first camera
+            geodesy::LocalFrame local(camera_llh(*geo, c, cam.get_pose(), offset));
+            glm::vec3 origin = cam.get_pose();
+            glm::mat3 to_local = glm::transpose(local_to_scene(*geo, local));
+            Frustum f = cam.get_frustum();
+            for (auto &p : f)
+                p = to_local * (p - origin);
+            double height = offset.y + cam.get_ground();
+            Footprint fp = ground_footprint(f, (float)(height - local.origin().z));
+            for (int i = 0; i < fp.n; i++) {
+                glm::dvec3 enu(fp.pt[i].x, -fp.pt[i].y, height - local.origin().z);
+                glm::dvec3 p = local.enu_to_llh(enu);
+                polygon.push_back({p.x, p.y});
+            }
+        } else {
+            const Footprint &fp = cam.get_footprint();
+            for (int i = 0; i < fp.n; i++) {
+                glm::vec3 world(fp.pt[i].x, cam.get_ground(), fp.pt[i].y);
+                glm::dvec3 p = world_to_utm(world, offset);
+                polygon.push_back({p.x, p.y});
+            }
+        }
+        j.push_back({{"cam-id", cam.get_id()},
+                     {"height", offset.y + cam.get_ground()},
+                     {"polygon", polygon}});
+    }
+
+    if (file == "-") {
+        cout << j.dump(2) << endl;
+        return;
+    }
+    ofstream file_handler(file);
+    if (!file_handler.is_open()) {
+        cerr << "writing footprint json fail!" << endl;
+        exit(EXIT_FAILURE);
+    }
+    file_handler << j.dump(2) << endl;
+}
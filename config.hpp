@@ -0,0 +1,67 @@
+#ifndef __CONFIG_HPP__
+#define __CONFIG_HPP__
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "camera.hpp"
+#include "geodesy.hpp"
+#include "projection.hpp"
+
+// Frame of a geodetic config. Instead of "xyz" in UTM, entries may give "llh":
+// [latitude, longitude, ellipsoidal height] in WGS84. Those are converted in batch to east /
+// north / up metres in the tangent plane at the first camera, which then take the place of
+// (easting, northing, height) everywhere, so a scene is free to span UTM zones.
+// That plane is only horizontal near the first camera, so every camera also keeps the east /
+// north / up frame at its own position, in double precision. A camera's pry is relative to
+// its own frame, and ground heights are ellipsoidal heights.
+struct GeoFrame {
+    bool geodetic = false;
+    geodesy::LocalFrame enu;
+    // one per camera, in cam.json order
+    std::vector<geodesy::LocalFrame> local;
+};
+
+// rotation of world axes (east, up, -north) from a camera's own frame into the scene's
+glm::mat3 local_to_scene(const GeoFrame &geo, const geodesy::LocalFrame &local);
+
+// cam.json / object.json positions are UTM (easting, northing, height), or llh (see GeoFrame).
+// The first camera's position becomes `offset`, stored as (easting, height, northing) in double
+// precision, and every other position is taken relative to it. A config uses one or the other
+// for all entries, `geo` receives which one. Objects in llh need the GeoFrame of their cameras
+std::vector<Camera> read_cam_config(const std::string &file, glm::dvec3 &offset,
+                                    GeoFrame *geo = nullptr);
+std::vector<Object> read_obj_config(const std::string &file, const glm::dvec3 &offset,
+                                    const GeoFrame *geo = nullptr);
+
+// cameras back to cam.json, positions in UTM or, for a geodetic config, in llh. "-" writes to
+// stdout
+void write_cam_config(const std::string &file, const std::vector<Camera> &cams,
+                      const glm::dvec3 &offset, const GeoFrame *geo = nullptr);
+
+// ground footprint of every camera as a json array of
+// {"cam-id", "height", "polygon": [[easting, northing], ...]} in UTM, or
+// [[latitude, longitude], ...] for a geodetic config, cut at the ground height in the camera's
+// own frame then. "-" writes to stdout
+void write_footprints(const std::string &file, const std::vector<Camera> &cams,
+                      const glm::dvec3 &offset, const GeoFrame *geo = nullptr);
+
+// scene world position (x, height, -northing relative to offset) back to UTM
+inline glm::dvec3 world_to_utm(const glm::vec3 &world, const glm::dvec3 &offset) {
+    return glm::dvec3(offset.x + world.x, offset.z - world.z, offset.y + world.y);
+}
+
+// UTM (easting, northing, height) to scene world position
+inline glm::vec3 utm_to_world(const glm::dvec3 &utm, const glm::dvec3 &offset) {
+    return glm::vec3(utm.x - offset.x, utm.z - offset.y, -(utm.y - offset.z));
+}
+
+// scene world position to (latitude, longitude, height) of a geodetic config
+inline glm::dvec3 world_to_llh(const glm::vec3 &world, const glm::dvec3 &offset,
+                               const GeoFrame &geo) {
+    return geo.enu.enu_to_llh(world_to_utm(world, offset));
+}
+
+#endif
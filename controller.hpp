@@ -1,11 +1,11 @@
 #ifndef __CONTROLLER_HPP__
 #define __CONTROLLER_HPP__
 
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 
 #include <algorithm>
+#include <cmath>
 
 constexpr float FOV = 45.f;
 constexpr float SENSITIVITY = 0.1f;
@@ -18,9 +18,16 @@ constexpr int HEIGHT = 600;
 constexpr float ZNEAR = 0.1f;
 constexpr float ZFAR = 1000.f;
 
+// Orbit camera of the viewer.
+// Mouse handlers apply every OS event to the orbit state (angles with the pitch clamp, target,
+// zoom) but leave the cached view / projection matrices alone. update(), called once per frame,
+// rebuilds them, so high-rate mice cost one matrix update per frame instead of one per event.
+// A pan only translates the view, so between rebuilds the cursor is unprojected through the
+// cached inverse plus that translation. A pan that follows a rotation or zoom rebuilds first.
+// The end result is the same as rebuilding after every event.
 class Controller {
   public:
-    Controller() : zoom_(FOV) {
+    Controller() : zoom_(FOV), shift_(0.f), moved_(false), stale_(false) {
         pos_ = glm::vec3(0, 10, 10);
         tar_ = glm::vec3(0, 0, 0);
 
@@ -56,9 +63,13 @@ class Controller {
             pitch_ = glm::degrees(atan2f(-mat[2][1], mat[2][2]));
         }
         yaw_ = -yaw_;
+
+        update_matrices();
     };
 
     void handle_mouse_button(const float &xpos, const float &ypos) {
+        refresh();
+
         last_x_ = static_cast<float>(xpos);
         last_y_ = static_cast<float>(ypos);
 
@@ -66,6 +77,71 @@ class Controller {
     }
 
     void handle_mouse_rotate(const float &xpos, const float &ypos) {
+        rotate(xpos, ypos);
+        moved_ = stale_ = true;
+    }
+
+    void handle_mouse_transpose(const float &xpos, const float &ypos) {
+        refresh();
+        transpose(xpos, ypos);
+        moved_ = true;
+    }
+
+    void handle_mouse_scroll(const float &yoffset) {
+        scroll(yoffset);
+        moved_ = stale_ = true;
+    }
+
+    // rebuild the matrices after the events since the last call, returns true if the view
+    // changed
+    bool update() {
+        if (!moved_)
+            return false;
+        update_matrices();
+        moved_ = false;
+        return true;
+    }
+
+    glm::mat4 get_model() const { return glm::mat4(1.f); };
+    const glm::mat4 &get_view() const { return view_; };
+    const glm::mat4 &get_projection() const { return proj_; };
+    // projection * view * model
+    const glm::mat4 &get_mvp() const { return mvp_; };
+
+    // unproject a cursor position onto the far plane
+    glm::vec3 get_world_pos(const float &xpos, const float &ypos) const {
+        int viewport[4] = {0, 0, WIDTH, HEIGHT};
+
+        glm::vec4 ndc;
+        ndc.x = 2 * (xpos - (float)viewport[0]) / (float)viewport[2] - 1.f;
+        ndc.y = 2 * (HEIGHT - ypos - (float)viewport[1]) / (float)viewport[3] - 1.f;
+        ndc.z = 1.f;
+        ndc.w = 1.f;
+
+        glm::vec4 pos = inv_mvp_ * ndc;
+        pos /= pos.w;
+
+        // the pans since the matrices were built
+        return glm::vec3(pos) + shift_;
+    }
+
+  private:
+    void update_matrices() {
+        view_ = glm::lookAt(pos_, tar_ + forward_, up_);
+        proj_ = glm::perspective(glm::radians(zoom_), WIDTH / (float)HEIGHT, ZNEAR, ZFAR);
+        mvp_ = proj_ * view_ * get_model();
+        inv_mvp_ = glm::inverse(mvp_);
+        shift_ = glm::vec3(0.f);
+        stale_ = false;
+    }
+
+    // a rotation or zoom since the last build changes more than a translation
+    void refresh() {
+        if (stale_)
+            update_matrices();
+    }
+
+    void rotate(const float &xpos, const float &ypos) {
         float xoffset = last_x_ - xpos;
         float yoffset = ypos - last_y_;
 
@@ -92,7 +168,7 @@ class Controller {
         pos_ = tar_ + distance_ * forward_;
     }
 
-    void handle_mouse_transpose(const float &xpos, const float &ypos) {
+    void transpose(const float &xpos, const float &ypos) {
         glm::vec3 world_pos = get_world_pos(xpos, ypos);
 
         tar_.x += SPEED * (last_world_ - world_pos).x;
@@ -101,38 +177,18 @@ class Controller {
         pos_.x += SPEED * (last_world_ - world_pos).x;
         pos_.z += SPEED * (last_world_ - world_pos).z;
 
+        shift_.x += SPEED * (last_world_ - world_pos).x;
+        shift_.z += SPEED * (last_world_ - world_pos).z;
+
         last_world_ = world_pos;
     }
 
-    void handle_mouse_scroll(const float &yoffset) {
+    void scroll(const float &yoffset) {
         zoom_ -= yoffset;
         zoom_ = std::min(zoom_, 1000.f);
         zoom_ = std::max(zoom_, 1.f);
     }
 
-    glm::mat4 get_model() const { return glm::mat4(1.f); };
-    glm::mat4 get_view() const { return glm::lookAt(pos_, tar_ + forward_, up_); };
-    glm::mat4 get_projection() const {
-        return glm::perspective(glm::radians(zoom_), WIDTH / (float)HEIGHT, ZNEAR, ZFAR);
-    };
-
-  private:
-    glm::vec3 get_world_pos(const float &xpos, const float &ypos) {
-        GLint viewport[4] = {0, 0, WIDTH, HEIGHT};
-
-        glm::vec4 ndc;
-        ndc.x = 2 * (xpos - (float)viewport[0]) / (float)viewport[2] - 1.f;
-        ndc.y = 2 * (HEIGHT - ypos - (float)viewport[1]) / (float)viewport[3] - 1.f;
-        ndc.z = 1.f;
-        ndc.w = 1.f;
-
-        glm::mat4 inv_mvp = glm::inverse(get_projection() * get_view() * get_model());
-        glm::vec4 pos = inv_mvp * ndc;
-        pos /= pos.w;
-
-        return glm::vec3(pos);
-    }
-
   private:
     glm::vec3 pos_;
     glm::vec3 tar_;
@@ -152,5 +208,15 @@ class Controller {
 
     float pitch_;
     float yaw_;
+
+    glm::mat4 view_;
+    glm::mat4 proj_;
+    glm::mat4 mvp_;
+    glm::mat4 inv_mvp_;
+    // translation of the view by pans since the matrices were built
+    glm::vec3 shift_;
+    // the view changed since the last update(), and changed by more than shift_
+    bool moved_;
+    bool stale_;
 };
 #endif
@@ -0,0 +1,149 @@
+#include "coverage.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+using namespace std;
+
+namespace {
+constexpr int TILE_CELLS = COVERAGE_TILE * COVERAGE_TILE;
+}
+
+CoverageGrid::CoverageGrid(float size, float step) : size_(size), step_(step), version_(0) {
+    cells_ = (int)ceil(2 * size / step);
+    tiles_ = (cells_ + COVERAGE_TILE - 1) / COVERAGE_TILE;
+    counts_.assign((size_t)tiles_ * tiles_ * TILE_CELLS, 0);
+    versions_.assign((size_t)tiles_ * tiles_, 0);
+}
+
+uint16_t CoverageGrid::at(int x, int z) const {
+    int t = (z / COVERAGE_TILE) * tiles_ + x / COVERAGE_TILE;
+    return counts_[(size_t)t * TILE_CELLS + (z % COVERAGE_TILE) * COVERAGE_TILE + x % COVERAGE_TILE];
+}
+
+uint16_t CoverageGrid::max_count() const {
+    uint16_t res = 0;
+    for (uint16_t c : counts_)
+        res = max(res, c);
+    return res;
+}
+
+template <typename F> void CoverageGrid::raster(const Footprint &fp, F &&fn) const {
+    if (fp.empty())
+        return;
+
+    float z_min = fp.pt[0].y, z_max = fp.pt[0].y;
+    for (int i = 1; i < fp.n; i++) {
+        z_min = min(z_min, fp.pt[i].y);
+        z_max = max(z_max, fp.pt[i].y);
+    }
+
+    int z0 = max(0, (int)ceil((z_min + size_) / step_ - 0.5f));
+    int z1 = min(cells_ - 1, (int)floor((z_max + size_) / step_ - 0.5f));
+    for (int z = z0; z <= z1; z++) {
+        // the polygon is convex, so every row crosses it in a single span
+        float zc = -size_ + (z + 0.5f) * step_;
+        float x_lo = numeric_limits<float>::max();
+        float x_hi = -numeric_limits<float>::max();
+        for (int i = 0; i < fp.n; i++) {
+            const glm::vec2 &a = fp.pt[i];
+            const glm::vec2 &b = fp.pt[(i + 1) % fp.n];
+            if ((a.y > zc && b.y > zc) || (a.y < zc && b.y < zc))
+                continue;
+            float x = a.y == b.y ? a.x : a.x + (zc - a.y) * (b.x - a.x) / (b.y - a.y);
+            x_lo = min(x_lo, a.y == b.y ? min(a.x, b.x) : x);
+            x_hi = max(x_hi, a.y == b.y ? max(a.x, b.x) : x);
+        }
+        if (x_lo > x_hi)
+            continue;
+
+        int x0 = max(0, (int)ceil((x_lo + size_) / step_ - 0.5f));
+        int x1 = min(cells_ - 1, (int)floor((x_hi + size_) / step_ - 0.5f));
+        if (x0 <= x1)
+            fn(z, x0, x1 + 1);
+    }
+}
+
+void CoverageGrid::add(const Footprint &fp, int delta) {
+    version_++;
+    raster(fp, [&](int z, int x_begin, int x_end) {
+        int tz = z / COVERAGE_TILE;
+        for (int x = x_begin; x < x_end; x++) {
+            int t = tz * tiles_ + x / COVERAGE_TILE;
+            uint16_t &count = counts_[(size_t)t * TILE_CELLS + (z % COVERAGE_TILE) * COVERAGE_TILE +
+                                      x % COVERAGE_TILE];
+            count = (uint16_t)max(0, (int)count + delta);
+            versions_[t] = version_;
+        }
+    });
+}
+
+void CoverageGrid::update(const Footprint &before, const Footprint &after) {
+    add(before, -1);
+    add(after, 1);
+}
+
+void CoverageGrid::rebuild(Span<const Footprint> footprints, Scheduler &scheduler) {
+    size_t n_tiles = versions_.size();
+
+    // per-thread tiles, allocated on first touch
+    vector<vector<unique_ptr<int32_t[]>>> partial(scheduler.size());
+    for (auto &tiles : partial)
+        tiles.resize(n_tiles);
+
+    scheduler.parallel_for(0, footprints.size(), 16, [&](size_t begin, size_t end) {
+        auto &tiles = partial[scheduler.this_worker()];
+        for (size_t i = begin; i < end; i++) {
+            raster(footprints[i], [&](int z, int x_begin, int x_end) {
+                int tz = z / COVERAGE_TILE;
+                for (int x = x_begin; x < x_end; x++) {
+                    auto &tile = tiles[tz * tiles_ + x / COVERAGE_TILE];
+                    if (!tile) {
+                        tile.reset(new int32_t[TILE_CELLS]);
+                        fill(tile.get(), tile.get() + TILE_CELLS, 0);
+                    }
+                    tile[(z % COVERAGE_TILE) * COVERAGE_TILE + x % COVERAGE_TILE]++;
+                }
+            });
+        }
+    });
+
+    version_++;
+    scheduler.parallel_for(0, n_tiles, 16, [&](size_t begin, size_t end) {
+        int32_t sum[TILE_CELLS];
+        for (size_t t = begin; t < end; t++) {
+            fill(sum, sum + TILE_CELLS, 0);
+            for (const auto &tiles : partial)
+                if (tiles[t])
+                    for (int c = 0; c < TILE_CELLS; c++)
+                        sum[c] += tiles[t][c];
+
+            uint16_t *dst = &counts_[t * TILE_CELLS];
+            bool changed = false;
+            for (int c = 0; c < TILE_CELLS; c++) {
+                uint16_t v = (uint16_t)min<int32_t>(sum[c], numeric_limits<uint16_t>::max());
+                changed |= dst[c] != v;
+                dst[c] = v;
+            }
+            if (changed)
+                versions_[t] = version_;
+        }
+    });
+}
+
+void CoverageGrid::sync(const CoverageGrid &src) {
+    if (cells_ != src.cells_ || size_ != src.size_ || step_ != src.step_) {
+        *this = src;
+        return;
+    }
+    for (size_t t = 0; t < versions_.size(); t++) {
+        if (versions_[t] == src.versions_[t])
+            continue;
+        memcpy(&counts_[t * TILE_CELLS], &src.counts_[t * TILE_CELLS], TILE_CELLS * sizeof(uint16_t));
+        versions_[t] = src.versions_[t];
+    }
+    version_ = src.version_;
+}
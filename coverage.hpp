@@ -0,0 +1,63 @@
+#ifndef __COVERAGE_HPP__
+#define __COVERAGE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "footprint.hpp"
+#include "scheduler.hpp"
+#include "span.hpp"
+
+constexpr int COVERAGE_TILE = 16;
+
+// Number of cameras seeing each cell of the XZ ground grid [-size, size]^2.
+// Counts are stored tile-major (COVERAGE_TILE x COVERAGE_TILE cells per tile) and every tile
+// carries a version that changes whenever its counts do, so copies and GPU textures only need
+// to pick up the tiles that moved.
+class CoverageGrid {
+  public:
+    CoverageGrid() : size_(0), step_(1), cells_(0), tiles_(0), version_(0){};
+    CoverageGrid(float size, float step);
+
+    float size() const { return size_; }
+    float step() const { return step_; }
+    // cells along x and z
+    int cells() const { return cells_; }
+    // tiles along x and z
+    int tiles() const { return tiles_; }
+
+    uint16_t at(int x, int z) const;
+    const uint16_t *tile(int tx, int tz) const {
+        return &counts_[(size_t)(tz * tiles_ + tx) * COVERAGE_TILE * COVERAGE_TILE];
+    }
+    uint64_t tile_version(int tx, int tz) const { return versions_[tz * tiles_ + tx]; }
+    // highest count over the grid
+    uint16_t max_count() const;
+
+    // recount from scratch: footprints are rasterized in parallel into per-thread tiles,
+    // which are summed at the end
+    void rebuild(Span<const Footprint> footprints, Scheduler &scheduler);
+    // a single camera moved, only the tiles under its old and new footprint change
+    void update(const Footprint &before, const Footprint &after);
+
+    // bring this copy up to date with `src`, copying only the tiles whose version differs
+    void sync(const CoverageGrid &src);
+
+  private:
+    // call fn(z, x_begin, x_end) for every grid row z whose cell centers the polygon covers
+    template <typename F> void raster(const Footprint &fp, F &&fn) const;
+    void add(const Footprint &fp, int delta);
+
+  private:
+    float size_;
+    float step_;
+    int cells_;
+    int tiles_;
+
+    std::vector<uint16_t> counts_;
+    std::vector<uint64_t> versions_;
+    uint64_t version_;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "depth_query.hpp"
+
+#include <cmath>
+
+#include "projection.hpp"
+
+using namespace std;
+
+DepthQuery::DepthQuery() : head_(0), tail_(0), in_flight_(0) {
+    for (auto &slot : slots_)
+        glGenBuffers(1, &slot.pbo);
+}
+
+DepthQuery::~DepthQuery() {
+    for (auto &slot : slots_) {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.pbo);
+    }
+}
+
+future<DepthSample> DepthQuery::request(int x, int y) {
+    pending_.push_back(Request{glm::ivec2(x, y), promise<DepthSample>()});
+    return pending_.back().result.get_future();
+}
+
+void DepthQuery::capture(const glm::mat4 &mvp, int width, int height) {
+    // with every slot still in flight the requests wait for the next frame
+    if (pending_.empty() || in_flight_ == DEPTH_QUERY_RING)
+        return;
+
+    Slot &slot = slots_[head_];
+    slot.mvp = mvp;
+    slot.inv_mvp = glm::inverse(mvp);
+    slot.width = width;
+    slot.height = height;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (pending_.size() > slot.capacity) {
+        slot.capacity = pending_.size();
+        glBufferData(GL_PIXEL_PACK_BUFFER, slot.capacity * sizeof(GLfloat), nullptr,
+                     GL_STREAM_READ);
+    }
+
+    // one pixel per request, each copy lands at its request's index in the buffer
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    for (size_t i = 0; i < pending_.size(); i++) {
+        const glm::ivec2 &px = pending_[i].px;
+        if (px.x < 0 || px.y < 0 || px.x >= width || px.y >= height)
+            continue;
+        glReadPixels(px.x, px.y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT,
+                     (void *)(i * sizeof(GLfloat)));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // both vectors keep their capacity
+    slot.requests.swap(pending_);
+    head_ = (head_ + 1) % DEPTH_QUERY_RING;
+    in_flight_++;
+}
+
+void DepthQuery::resolve() {
+    // readbacks complete in the order they were issued
+    while (in_flight_ > 0) {
+        Slot &slot = slots_[tail_];
+        GLenum state = glClientWaitSync(slot.fence, 0, 0);
+        if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED)
+            return;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const GLfloat *depth = static_cast<const GLfloat *>(glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, slot.requests.size() * sizeof(GLfloat), GL_MAP_READ_BIT));
+
+        for (size_t i = 0; i < slot.requests.size(); i++) {
+            Request &req = slot.requests[i];
+            DepthSample res{req.px, 1.f, NAN, glm::vec3(NAN), false};
+            bool inside = req.px.x >= 0 && req.px.y >= 0 && req.px.x < slot.width &&
+                          req.px.y < slot.height;
+            if (depth && inside)
+                res.depth = depth[i];
+
+            // the cleared depth means nothing was drawn there
+            if (res.depth < 1.f) {
+                glm::vec3 win(req.px.x + 0.5f, res.depth, req.px.y + 0.5f);
+                res.world = projection::unproject(win, slot.inv_mvp, slot.width, slot.height);
+                // clip w of a perspective projection is the depth along the view axis
+                res.linear = (slot.mvp * glm::vec4(res.world, 1.f)).w;
+                res.hit = true;
+            }
+            req.result.set_value(res);
+        }
+
+        if (depth)
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.requests.clear();
+        tail_ = (tail_ + 1) % DEPTH_QUERY_RING;
+        in_flight_--;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef __DEPTH_QUERY_HPP__
+#define __DEPTH_QUERY_HPP__
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <future>
+#include <vector>
+
+// frames a readback may stay in flight before its slot of the ring is needed again
+constexpr int DEPTH_QUERY_RING = 3;
+
+struct DepthSample {
+    glm::ivec2 px; // framebuffer pixel, row counted from the bottom
+    float depth;   // window depth in [0, 1]
+    float linear;  // distance along the view axis
+    glm::vec3 world;
+    // false when nothing was drawn at the pixel (cleared depth), linear and world are nan then
+    bool hit;
+};
+
+// Depth buffer values at requested pixels without stalling the pipeline.
+// Every frame the pixels requested since the last capture() are copied from the depth buffer
+// into one pixel pack buffer of a small ring and a fence is placed behind the copies. resolve()
+// maps a buffer only once its fence has signalled, a frame or two later, and fulfils the
+// futures with the depth turned into linear depth and a world position by the mvp of the
+// frame it was captured from.
+class DepthQuery {
+  public:
+    DepthQuery();
+    ~DepthQuery();
+
+    // pixel (x, y counted from the bottom) of the framebuffer of the next capture()
+    std::future<DepthSample> request(int x, int y);
+    // read the requested pixels of the bound framebuffer, after the scene and before the swap
+    void capture(const glm::mat4 &mvp, int width, int height);
+    // fulfil the requests of every completed readback, never waits
+    void resolve();
+    // requests not resolved yet
+    bool busy() const { return !pending_.empty() || in_flight_ > 0; }
+
+  private:
+    struct Request {
+        glm::ivec2 px;
+        std::promise<DepthSample> result;
+    };
+
+    struct Slot {
+        GLuint pbo = 0;
+        size_t capacity = 0; // pixels
+        GLsync fence = nullptr;
+        glm::mat4 inv_mvp;
+        glm::mat4 mvp;
+        int width = 0;
+        int height = 0;
+        std::vector<Request> requests;
+    };
+
+  private:
+    Slot slots_[DEPTH_QUERY_RING];
+    // next slot to capture into and the oldest one in flight
+    int head_;
+    int tail_;
+    int in_flight_;
+    std::vector<Request> pending_;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "draw_batch.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "alloc_track.hpp"
+
+using namespace std;
+
+namespace {
+// floats per vertex, see Frame
+constexpr size_t VERTEX = 6;
+} // namespace
+
+DrawBatch::DrawBatch() : capacity_(0), uploaded_seq_(~uint64_t(0)), commands_{} {
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glGenBuffers(1, &indirect_);
+
+    // the VAO keeps the layout and the buffer name across reallocations of the arena
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX * sizeof(float),
+                          (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    multi_draw_ = GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+    if (multi_draw_) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(commands_), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
+
+DrawBatch::~DrawBatch() {
+    glDeleteBuffers(1, &indirect_);
+    glDeleteBuffers(1, &vbo_);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void DrawBatch::upload(const Frame &frame) {
+    if (frame.seq == uploaded_seq_)
+        return;
+    uploaded_seq_ = frame.seq;
+    AllocScope alloc_scope("upload");
+
+    // the classes back to back, in Class order
+    const vector<GLfloat> *src[CLASSES] = {&frame.point, &frame.line, &frame.plane};
+    size_t total = 0;
+    for (int c = 0; c < CLASSES; c++) {
+        commands_[c] = Command{(GLuint)(src[c]->size() / VERTEX), 1, (GLuint)(total / VERTEX), 0};
+        total += src[c]->size();
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    if (total > capacity_) {
+        // round up so a slowly growing scene does not reallocate every frame
+        capacity_ = max(total, capacity_ + capacity_ / 2);
+        glBufferData(GL_ARRAY_BUFFER, capacity_ * sizeof(GLfloat), nullptr, GL_STREAM_DRAW);
+    }
+    GLfloat *dst = nullptr;
+    if (total > 0)
+        dst = static_cast<GLfloat *>(
+            glMapBufferRange(GL_ARRAY_BUFFER, 0, total * sizeof(GLfloat),
+                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (dst) {
+        for (int c = 0; c < CLASSES; c++)
+            copy(src[c]->begin(), src[c]->end(), dst + commands_[c].first * VERTEX);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else {
+        for (auto &cmd : commands_)
+            cmd.count = 0;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (multi_draw_) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(commands_), commands_);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
+
+void DrawBatch::draw(const Shader &shader) {
+    auto submit = [&](GLenum mode, Class c) {
+        if (commands_[c].count == 0)
+            return;
+        if (multi_draw_)
+            glMultiDrawArraysIndirect(mode, (void *)(c * sizeof(Command)), 1, 0);
+        else
+            glDrawArrays(mode, commands_[c].first, commands_[c].count);
+    };
+
+    glBindVertexArray(vao_);
+    if (multi_draw_)
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_);
+
+    shader.set_float("alpha", 1.f);
+    submit(GL_LINES, LINES);
+    glPointSize(15);
+    submit(GL_POINTS, POINTS);
+
+    // translucent, so it must not hide what is drawn after it
+    shader.set_float("alpha", 0.3f);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    submit(GL_TRIANGLES, PLANES);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    shader.set_float("alpha", 1.f);
+
+    if (multi_draw_)
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
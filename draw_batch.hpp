@@ -0,0 +1,48 @@
+#ifndef __DRAW_BATCH_HPP__
+#define __DRAW_BATCH_HPP__
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame.hpp"
+#include "shader.hpp"
+
+// Points, lines and translucent planes of a Frame in one vertex arena behind one VAO.
+// The attribute layout is specified once. A new frame is copied into its sub-ranges with
+// a single invalidating map, and an unchanged frame is not uploaded again. The draws come from
+// an indirect buffer, one command per primitive class, opaque classes first. Without
+// GL 4.3 / ARB_multi_draw_indirect the same ranges are drawn with glDrawArrays.
+class DrawBatch {
+  public:
+    DrawBatch();
+    ~DrawBatch();
+
+    void upload(const Frame &frame);
+    // draw with `shader` in use, its "alpha" uniform is set per class
+    void draw(const Shader &shader);
+
+  private:
+    // DrawArraysIndirectCommand
+    struct Command {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first;
+        GLuint base_instance;
+    };
+
+    enum Class { POINTS, LINES, PLANES, CLASSES };
+
+  private:
+    GLuint vao_;
+    GLuint vbo_;
+    GLuint indirect_;
+    bool multi_draw_;
+
+    size_t capacity_; // floats
+    uint64_t uploaded_seq_;
+    Command commands_[CLASSES];
+};
+
+#endif
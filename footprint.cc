@@ -0,0 +1,55 @@
+#include "footprint.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+float cross(const glm::vec2 &o, const glm::vec2 &a, const glm::vec2 &b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+} // namespace
+
+Footprint ground_footprint(const Frustum &f, float ground) {
+    // edge / plane crossings, corners lying on the plane show up once per touching edge
+    glm::vec2 pts[24];
+    int n = 0;
+    for (const auto &edge : FRUSTUM_EDGES) {
+        const glm::vec3 &a = f[edge[0]];
+        const glm::vec3 &b = f[edge[1]];
+        float da = a.y - ground;
+        float db = b.y - ground;
+        if ((da > 0 && db > 0) || (da < 0 && db < 0))
+            continue;
+        if (da == db) {
+            pts[n++] = glm::vec2(a.x, a.z);
+            pts[n++] = glm::vec2(b.x, b.z);
+            continue;
+        }
+        glm::vec3 p = a + (b - a) * (da / (da - db));
+        pts[n++] = glm::vec2(p.x, p.z);
+    }
+
+    // monotone chain convex hull, also drops the duplicates
+    sort(pts, pts + n, [](const glm::vec2 &a, const glm::vec2 &b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    glm::vec2 hull[48];
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], pts[i]) <= 0)
+            k--;
+        hull[k++] = pts[i];
+    }
+    for (int i = n - 2, lower = k + 1; i >= 0; i--) {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], pts[i]) <= 0)
+            k--;
+        hull[k++] = pts[i];
+    }
+
+    Footprint res;
+    res.n = min(max(k - 1, 0), Footprint::MAX_POINTS);
+    for (int i = 0; i < res.n; i++)
+        res.pt[i] = hull[i];
+    return res;
+}
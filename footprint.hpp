@@ -0,0 +1,22 @@
+#ifndef __FOOTPRINT_HPP__
+#define __FOOTPRINT_HPP__
+
+#include <glm/glm.hpp>
+
+#include "frustum.hpp"
+
+// Convex polygon where a view frustum meets a horizontal ground plane, as counter-clockwise
+// (x, z) points. A plane cuts the 12 frustum edges in at most 6 points.
+struct Footprint {
+    static constexpr int MAX_POINTS = 6;
+
+    glm::vec2 pt[MAX_POINTS];
+    int n = 0;
+
+    bool empty() const { return n < 3; }
+};
+
+// intersection of the frustum with the plane y = ground, already clipped by near and far
+Footprint ground_footprint(const Frustum &f, float ground = 0.f);
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef __FRAME_HPP__
+#define __FRAME_HPP__
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "camera.hpp"
+#include "coverage.hpp"
+#include "projection.hpp"
+#include "span.hpp"
+
+// Geometry of one simulation step. Built by the simulation thread and handed to the render
+// thread through a TripleBuffer, after which it is never modified until it is recycled.
+// Every vertex is laid out as (x, y, z, r, g, b). `plane` holds triangles drawn translucent.
+// point_id has one pick id per point vertex (see PICK_CAMERA / PICK_OBJECT).
+// The visibility table lists, for every camera, the ids of the objects inside its frustum and
+// in line of sight past the occluders.
+struct Frame {
+    uint64_t seq = 0;
+
+    std::vector<GLfloat> point;
+    std::vector<GLuint> point_id;
+    std::vector<GLfloat> line;
+    std::vector<GLfloat> plane;
+
+    // kept across clear(), each step syncs the tiles that changed since this buffer was last used
+    CoverageGrid coverage;
+
+    // cameras and objects as drawn. a PICK_CAMERA id indexes cameras, a PICK_OBJECT id is
+    // looked up in objects by Object::id
+    std::vector<CameraParams> cameras;
+    std::vector<Object> objects;
+    // ids seen by camera i are visible_id[visible_start[i], visible_start[i + 1])
+    std::vector<uint32_t> visible_start;
+    std::vector<int> visible_id;
+    // trajectory playback time, nan without trajectories
+    double time = NAN;
+
+    void clear() {
+        point.clear();
+        point_id.clear();
+        line.clear();
+        plane.clear();
+        visible_start.clear();
+        visible_id.clear();
+    }
+
+    size_t visible_count(size_t cam) const {
+        return cam + 1 < visible_start.size() ? visible_start[cam + 1] - visible_start[cam] : 0;
+    }
+    Span<const int> visible(size_t cam) const {
+        size_t n = visible_count(cam);
+        return n ? Span<const int>(visible_id.data() + visible_start[cam], n) : Span<const int>();
+    }
+};
+
+// pick ids: kind in the top two bits, below them the index into the simulator's camera list
+// or the Object::id, which stays valid when a later frame reorders the objects. 0 is nothing
+constexpr GLuint PICK_CAMERA = 1u << 30;
+constexpr GLuint PICK_OBJECT = 2u << 30;
+constexpr GLuint PICK_KIND = 3u << 30;
+constexpr GLuint PICK_INDEX = ~PICK_KIND;
+
+// objects whose id does not fit below the kind bits (negative or >= 2^30) are not pickable
+inline bool pickable(int id) { return id >= 0 && (GLuint)id <= PICK_INDEX; }
+inline GLuint object_pick(int id) { return pickable(id) ? PICK_OBJECT | (GLuint)id : 0; }
+
+inline void push_vertex(std::vector<GLfloat> &dst, const glm::vec3 &pos, const glm::vec3 &color) {
+    dst.insert(dst.end(), {pos.x, pos.y, pos.z, color.x, color.y, color.z});
+}
+
+inline void push_point(Frame &frame, const glm::vec3 &pos, const glm::vec3 &color,
+                       GLuint pick = 0) {
+    push_vertex(frame.point, pos, color);
+    frame.point_id.push_back(pick);
+}
+
+inline void draw_grid_xz(Frame &frame, float size, float step) {
+    const glm::vec3 white(1.f, 1.f, 1.f);
+    for (float i = step; i <= size; i += step) {
+        // lines parallel to X-axis
+        push_vertex(frame.line, glm::vec3(-size, 0, i), white);
+        push_vertex(frame.line, glm::vec3(size, 0, i), white);
+        push_vertex(frame.line, glm::vec3(-size, 0, -i), white);
+        push_vertex(frame.line, glm::vec3(size, 0, -i), white);
+
+        // lines parallel to Z-axis
+        push_vertex(frame.line, glm::vec3(i, 0, -size), white);
+        push_vertex(frame.line, glm::vec3(i, 0, size), white);
+        push_vertex(frame.line, glm::vec3(-i, 0, -size), white);
+        push_vertex(frame.line, glm::vec3(-i, 0, size), white);
+    }
+
+    // x-axis
+    push_vertex(frame.line, glm::vec3(0, 0, 0), glm::vec3(1.f, 0, 0));
+    push_vertex(frame.line, glm::vec3(size, 0, 0), glm::vec3(1.f, 0, 0));
+    push_vertex(frame.line, glm::vec3(0, 0, 0), glm::vec3(1.f, 0, 0));
+    push_vertex(frame.line, glm::vec3(-size, 0, 0), white);
+
+    // z-axis
+    push_vertex(frame.line, glm::vec3(0, 0, 0), glm::vec3(0, 0, 1.f));
+    push_vertex(frame.line, glm::vec3(0, 0, size), glm::vec3(0, 0, 1.f));
+    push_vertex(frame.line, glm::vec3(0, 0, 0), glm::vec3(0, 0, 1.f));
+    push_vertex(frame.line, glm::vec3(0, 0, -size), white);
+}
+
+inline void draw_plane_xz(Frame &frame, float size) {
+    const glm::vec3 white(1.f, 1.f, 1.f);
+    push_vertex(frame.plane, glm::vec3(-size, 0, -size), white);
+    push_vertex(frame.plane, glm::vec3(size, 0, -size), white);
+    push_vertex(frame.plane, glm::vec3(size, 0, size), white);
+    push_vertex(frame.plane, glm::vec3(-size, 0, -size), white);
+    push_vertex(frame.plane, glm::vec3(size, 0, size), white);
+    push_vertex(frame.plane, glm::vec3(-size, 0, size), white);
+}
+
+// filled ground polygon at height `ground`, as a triangle fan
+inline void draw_footprint(Frame &frame, const Footprint &fp, const glm::vec3 &color,
+                           float ground) {
+    for (int i = 2; i < fp.n; i++) {
+        push_vertex(frame.plane, glm::vec3(fp.pt[0].x, ground, fp.pt[0].y), color);
+        push_vertex(frame.plane, glm::vec3(fp.pt[i - 1].x, ground, fp.pt[i - 1].y), color);
+        push_vertex(frame.plane, glm::vec3(fp.pt[i].x, ground, fp.pt[i].y), color);
+    }
+}
+
+inline void draw_camera(Frame &frame, const Camera &cam, const glm::vec3 &cam_color,
+                        GLuint pick = 0) {
+    push_point(frame, cam.get_pose(), cam_color, pick);
+
+    const Frustum &frustum = cam.get_frustum();
+    for (const auto &edge : FRUSTUM_EDGES) {
+        push_vertex(frame.line, frustum[edge[0]], glm::vec3(0, 1.f, 0));
+        push_vertex(frame.line, frustum[edge[1]], glm::vec3(0, 1.f, 0));
+    }
+}
+
+inline void draw_object(Frame &frame, const Object &obj, const glm::vec3 &obj_color,
+                        GLuint pick = 0) {
+    push_point(frame, obj.pt, obj_color, pick);
+}
+
+#endif
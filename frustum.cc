@@ -0,0 +1,29 @@
+#include "frustum.hpp"
+
+Aabb frustum_bounds(const Frustum &f) {
+    Aabb res{f[0], f[0]};
+    for (const auto &p : f) {
+        res.min = glm::min(res.min, p);
+        res.max = glm::max(res.max, p);
+    }
+    return res;
+}
+
+FrustumPlanes frustum_planes(const Frustum &f) {
+    glm::vec3 center(0);
+    for (const auto &p : f)
+        center += p;
+    center /= (float)f.size();
+
+    FrustumPlanes res;
+    for (int i = 0; i < 6; i++) {
+        const glm::vec3 &p0 = f[FRUSTUM_FACES[i][0]];
+        const glm::vec3 &p1 = f[FRUSTUM_FACES[i][1]];
+        const glm::vec3 &p3 = f[FRUSTUM_FACES[i][3]];
+        glm::vec3 n = glm::normalize(glm::cross(p1 - p0, p3 - p0));
+        if (glm::dot(n, center - p0) > 0)
+            n = -n;
+        res[i] = Plane{n, glm::dot(n, p0)};
+    }
+    return res;
+}
@@ -0,0 +1,45 @@
+#ifndef __FRUSTUM_HPP__
+#define __FRUSTUM_HPP__
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+// 8 world-space frustum corners, near plane first:
+// {-1,-1}, {1,-1}, {-1,1}, {1,1} in ndc x/y, then the same on the far plane
+using Frustum = std::array<glm::vec3, 8>;
+
+// corner index pairs of the 12 frustum edges
+constexpr int FRUSTUM_EDGES[12][2] = {
+    {0, 1}, {0, 2}, {0, 4}, {1, 3}, {1, 5}, {2, 3},
+    {2, 6}, {3, 7}, {4, 5}, {4, 6}, {5, 7}, {6, 7},
+};
+
+// corner indices of the 6 frustum faces, each a closed quad
+constexpr int FRUSTUM_FACES[6][4] = {
+    {0, 1, 3, 2}, // near
+    {4, 6, 7, 5}, // far
+    {0, 2, 6, 4}, // left
+    {1, 5, 7, 3}, // right
+    {0, 4, 5, 1}, // bottom
+    {2, 3, 7, 6}, // top
+};
+
+struct Aabb {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// points p with dot(n, p) <= d are inside
+struct Plane {
+    glm::vec3 n;
+    float d;
+};
+
+// outward facing planes in FRUSTUM_FACES order
+using FrustumPlanes = std::array<Plane, 6>;
+
+Aabb frustum_bounds(const Frustum &f);
+FrustumPlanes frustum_planes(const Frustum &f);
+
+#endif
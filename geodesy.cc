@@ -0,0 +1,107 @@
+#include "geodesy.hpp"
+
+#include <cassert>
+#include <cmath>
+
+using namespace std;
+
+namespace geodesy {
+
+namespace {
+
+constexpr double DEG = 3.14159265358979323846 / 180.0;
+// semi-minor axis and second eccentricity squared
+constexpr double WGS84_B = WGS84_A * (1.0 - WGS84_F);
+constexpr double WGS84_EP2 = WGS84_E2 / (1.0 - WGS84_E2);
+
+inline glm::dvec3 to_ecef(double lat, double lon, double h) {
+    double sin_lat = sin(lat), cos_lat = cos(lat);
+    double sin_lon = sin(lon), cos_lon = cos(lon);
+    // prime vertical radius of curvature
+    double n = WGS84_A / sqrt(1.0 - WGS84_E2 * sin_lat * sin_lat);
+    return glm::dvec3((n + h) * cos_lat * cos_lon, (n + h) * cos_lat * sin_lon,
+                      (n * (1.0 - WGS84_E2) + h) * sin_lat);
+}
+} // namespace
+
+glm::dvec3 llh_to_ecef(const glm::dvec3 &llh) { return to_ecef(llh.x * DEG, llh.y * DEG, llh.z); }
+
+void llh_to_ecef(Span<const glm::dvec3> llh, Span<glm::dvec3> out) {
+    assert(llh.size() == out.size());
+    for (size_t i = 0; i < llh.size(); i++)
+        out[i] = to_ecef(llh[i].x * DEG, llh[i].y * DEG, llh[i].z);
+}
+
+glm::dvec3 ecef_to_llh(const glm::dvec3 &ecef) {
+    double p = sqrt(ecef.x * ecef.x + ecef.y * ecef.y);
+    double lon = atan2(ecef.y, ecef.x);
+
+    // parametric latitude first guess, two Bowring iterations
+    double beta = atan2(ecef.z * WGS84_A, p * WGS84_B);
+    double lat = 0;
+    for (int k = 0; k < 2; k++) {
+        double sin_b = sin(beta), cos_b = cos(beta);
+        lat = atan2(ecef.z + WGS84_EP2 * WGS84_B * sin_b * sin_b * sin_b,
+                    p - WGS84_E2 * WGS84_A * cos_b * cos_b * cos_b);
+        beta = atan2((1.0 - WGS84_F) * sin(lat), cos(lat));
+    }
+
+    double sin_lat = sin(lat), cos_lat = cos(lat);
+    double n = WGS84_A / sqrt(1.0 - WGS84_E2 * sin_lat * sin_lat);
+    // the z based form avoids the division by cos(lat) near the poles
+    double h = fabs(cos_lat) > 0.1 ? p / cos_lat - n : ecef.z / sin_lat - n * (1.0 - WGS84_E2);
+    return glm::dvec3(lat / DEG, lon / DEG, h);
+}
+
+bool intersect_height(const glm::dvec3 &origin, const glm::dvec3 &dir, double h, glm::dvec3 &out) {
+    // the ellipsoid with both semi-axes grown by h is within metres of the height surface,
+    // newton steps along the ray then close the remaining gap
+    double a = WGS84_A + h, b = WGS84_B + h;
+    glm::dvec3 s(1.0 / a, 1.0 / a, 1.0 / b);
+    glm::dvec3 o = origin * s, d = dir * s;
+    double qa = glm::dot(d, d), qb = glm::dot(o, d), qc = glm::dot(o, o) - 1.0;
+    double disc = qb * qb - qa * qc;
+    if (qa == 0 || disc < 0)
+        return false;
+    // the nearer crossing in front of the origin, the far one when the origin is inside
+    double root = sqrt(disc);
+    double t = (-qb - root) / qa;
+    if (t < 0)
+        t = (-qb + root) / qa;
+    if (t < 0)
+        return false;
+
+    for (int k = 0; k < 3; k++) {
+        glm::dvec3 llh = ecef_to_llh(origin + t * dir);
+        double lat = llh.x * DEG, lon = llh.y * DEG;
+        glm::dvec3 up(cos(lat) * cos(lon), cos(lat) * sin(lon), sin(lat));
+        double rate = glm::dot(dir, up);
+        if (fabs(rate) < 1e-12)
+            break;
+        t -= (llh.z - h) / rate;
+    }
+    if (t < 0)
+        return false;
+    out = origin + t * dir;
+    return true;
+}
+
+LocalFrame::LocalFrame(const glm::dvec3 &origin_llh)
+    : origin_(origin_llh), origin_ecef_(llh_to_ecef(origin_llh)) {
+    double lat = origin_llh.x * DEG, lon = origin_llh.y * DEG;
+    double sin_lat = sin(lat), cos_lat = cos(lat);
+    double sin_lon = sin(lon), cos_lon = cos(lon);
+
+    // glm is column major, rot_[c][r]
+    glm::dvec3 east(-sin_lon, cos_lon, 0.0);
+    glm::dvec3 north(-sin_lat * cos_lon, -sin_lat * sin_lon, cos_lat);
+    glm::dvec3 up(cos_lat * cos_lon, cos_lat * sin_lon, sin_lat);
+    rot_ = glm::transpose(glm::dmat3(east, north, up));
+}
+
+void LocalFrame::llh_to_enu(Span<const glm::dvec3> llh, Span<glm::dvec3> out) const {
+    assert(llh.size() == out.size());
+    for (size_t i = 0; i < llh.size(); i++)
+        out[i] = rot_ * (to_ecef(llh[i].x * DEG, llh[i].y * DEG, llh[i].z) - origin_ecef_);
+}
+} // namespace geodesy
@@ -0,0 +1,61 @@
+#ifndef __GEODESY_HPP__
+#define __GEODESY_HPP__
+
+#include <glm/glm.hpp>
+
+#include "span.hpp"
+
+// WGS84 geodetic coordinates, all in double precision.
+// llh is (latitude deg, longitude deg, ellipsoidal height m), ecef is earth centred earth fixed
+// metres and enu is east / north / up metres in the tangent plane at some origin.
+namespace geodesy {
+
+constexpr double WGS84_A = 6378137.0;
+constexpr double WGS84_F = 1.0 / 298.257223563;
+constexpr double WGS84_E2 = WGS84_F * (2.0 - WGS84_F);
+
+glm::dvec3 llh_to_ecef(const glm::dvec3 &llh);
+void llh_to_ecef(Span<const glm::dvec3> llh, Span<glm::dvec3> out);
+// Bowring's method, sub-millimetre for heights within +-10 km of the ellipsoid
+glm::dvec3 ecef_to_llh(const glm::dvec3 &ecef);
+
+// first point of the ecef ray origin + t * dir, t >= 0, at ellipsoidal height h. false when
+// the ray never reaches that height
+bool intersect_height(const glm::dvec3 &origin, const glm::dvec3 &dir, double h, glm::dvec3 &out);
+
+// East / north / up frame at a fixed origin. The mapping from ecef is a rigid motion, so it
+// stays exact across UTM zone boundaries, only "up" tilts away from the local vertical by
+// about 0.009 degrees per km of distance from the origin, and the ground falls below the
+// tangent plane by about d^2 / 2R (785 m at 100 km). Anything that depends on the local
+// vertical far from the origin needs a frame of its own there, see rotation_to().
+class LocalFrame {
+  public:
+    LocalFrame() : LocalFrame(glm::dvec3(0.0)) {}
+    explicit LocalFrame(const glm::dvec3 &origin_llh);
+
+    const glm::dvec3 &origin() const { return origin_; }
+    const glm::dvec3 &origin_ecef() const { return origin_ecef_; }
+    // ecef -> enu rotation, rows are the east, north and up axes
+    const glm::dmat3 &rotation() const { return rot_; }
+    // takes enu vectors of this frame to enu vectors of `to`
+    glm::dmat3 rotation_to(const LocalFrame &to) const { return to.rot_ * glm::transpose(rot_); }
+
+    glm::dvec3 ecef_to_enu(const glm::dvec3 &ecef) const { return rot_ * (ecef - origin_ecef_); }
+    glm::dvec3 enu_to_ecef(const glm::dvec3 &enu) const {
+        return origin_ecef_ + glm::transpose(rot_) * enu;
+    }
+
+    glm::dvec3 llh_to_enu(const glm::dvec3 &llh) const { return ecef_to_enu(llh_to_ecef(llh)); }
+    glm::dvec3 enu_to_llh(const glm::dvec3 &enu) const { return ecef_to_llh(enu_to_ecef(enu)); }
+    // batch version, llh straight to enu without an ecef buffer in between
+    void llh_to_enu(Span<const glm::dvec3> llh, Span<glm::dvec3> out) const;
+
+  private:
+    glm::dvec3 origin_;
+    glm::dvec3 origin_ecef_;
+    // ecef -> enu rotation, rows are the east, north and up axes
+    glm::dmat3 rot_;
+};
+} // namespace geodesy
+
+#endif
@@ -3,38 +3,81 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-
 #include <json/json.hpp>
 
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <future>
 #include <iostream>
-#include <sstream>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "alloc_track.hpp"
+#include "benchmark.hpp"
+#include "bvh.hpp"
 #include "camera.hpp"
+#include "config.hpp"
 #include "controller.hpp"
+#include "depth_query.hpp"
+#include "draw_batch.hpp"
+#include "mesh.hpp"
+#include "picking.hpp"
 #include "projection.hpp"
 #include "shader.hpp"
+#include "simulator.hpp"
+#include "synthetic.hpp"
+#include "trails.hpp"
+#include "trajectory.hpp"
 
 using namespace std;
-using json = nlohmann::json;
 
-GLuint vao[3], vbo[3];
-vector<GLfloat> point, line, plane;
-glm::vec3 offset;
+// longest sleep of the on-demand loop without any event
+constexpr double IDLE_TIMEOUT = 1.0;
+
+glm::dvec3 offset;
+// llh configs, positions are then printed as latitude / longitude / height
+GeoFrame geo;
+
+// coverage heatmap quad and texture, and the tile versions the texture currently holds
+GLuint coverage_vao, coverage_vbo;
+GLuint coverage_tex;
+vector<uint64_t> coverage_uploaded;
+float coverage_max = 1.f;
 
 Controller control;
 
-void draw_grid_xz(float size, float step);
-void draw_plane_xz(float size);
-void draw_camera(Camera cam, glm::vec3 cam_color);
-void draw_object(Object obj, glm::vec3 obj_color);
+// ctrl + left click, in window coordinates
+bool pick_requested = false;
+double pick_x, pick_y;
+// shift + left click, depth and world position under the cursor
+bool depth_requested = false;
+double depth_x, depth_y;
+
+// the window contents were lost (expose, resize) and have to be drawn again
+bool redraw = true;
 
-void bind_line_opengl();
-void bind_point_opengl();
-void bind_plane_opengl();
+// playback keys act on it directly, its controls are thread safe
+Simulator *simulator = nullptr;
+
+void bind_coverage_opengl(const Frame &frame, Shader &shader);
+void print_pick(GLuint pick, const Frame &frame);
+void print_depth(const DepthSample &sample);
 
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && (mods & GLFW_MOD_CONTROL)) {
+        glfwGetCursorPos(window, &pick_x, &pick_y);
+        pick_requested = true;
+        return;
+    }
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && (mods & GLFW_MOD_SHIFT)) {
+        glfwGetCursorPos(window, &depth_x, &depth_y);
+        depth_requested = true;
+        return;
+    }
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS ||
         glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) {
         double xpos, ypos;
@@ -54,62 +97,120 @@ void mouse_scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
     control.handle_mouse_scroll(yoffset);
 }
 
-vector<Camera> read_cam_config(const std::string file) {
-    ifstream file_handler(file);
-    if (!file_handler.is_open()) {
-        cerr << "reading config json fail!" << endl;
-        exit(EXIT_FAILURE);
+void window_refresh_callback(GLFWwindow *window) { redraw = true; }
+
+// trajectory playback: space play / pause, left / right seek 1 s (10 s with shift),
+// up / down double / halve the rate, home / end jump to the ends
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    if (!simulator || !simulator->has_trajectories() || action == GLFW_RELEASE)
+        return;
+
+    double step = (mods & GLFW_MOD_SHIFT) ? 10.0 : 1.0;
+    switch (key) {
+    case GLFW_KEY_SPACE:
+        if (action == GLFW_PRESS)
+            simulator->toggle_play();
+        break;
+    case GLFW_KEY_LEFT:
+        simulator->seek(simulator->time() - step);
+        break;
+    case GLFW_KEY_RIGHT:
+        simulator->seek(simulator->time() + step);
+        break;
+    case GLFW_KEY_UP:
+        simulator->set_rate(simulator->rate() * 2);
+        break;
+    case GLFW_KEY_DOWN:
+        simulator->set_rate(simulator->rate() / 2);
+        break;
+    case GLFW_KEY_HOME:
+        simulator->seek(-INFINITY);
+        break;
+    case GLFW_KEY_END:
+        simulator->seek(INFINITY);
+        break;
     }
+}
 
-    string json_data;
-    std::ostringstream json_oss;
-    json_oss << file_handler.rdbuf();
-    json_data = json_oss.str();
-    file_handler.close();
-
-    bool is_first = true;
-    vector<Camera> res;
-    for (auto &j : json::parse(json_data)) {
-        if (is_first) {
-            offset = glm::vec3(j["xyz"][0], j["xyz"][2], j["xyz"][1]);
-            is_first = false;
+int main(int argc, char **argv) {
+    string occluder_file, trajectory_file;
+    // --on-demand: only draw on input, a new simulation frame or a pending pick
+    bool on_demand = false;
+    // frame rate cap, 0 for none
+    double max_fps = 0;
+    // samples kept per object trail, 0 for none
+    int trail_length = TRAIL_LENGTH;
+    // --benchmark: render this many frames without vsync and print timing statistics as JSON
+    size_t benchmark_frames = 0;
+    // replace the config scene by this many random cameras
+    size_t synthetic_cams = 0;
+    // with --benchmark: fail when a recorded frame touched the heap
+    bool assert_zero_alloc = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--occluders" && i + 1 < argc) {
+            occluder_file = argv[++i];
+        } else if (arg == "--trajectory" && i + 1 < argc) {
+            trajectory_file = argv[++i];
+        } else if (arg == "--on-demand") {
+            on_demand = true;
+        } else if (arg == "--fps" && i + 1 < argc) {
+            max_fps = atof(argv[++i]);
+        } else if (arg == "--trails" && i + 1 < argc) {
+            trail_length = atoi(argv[++i]);
+        } else if (arg == "--benchmark" && i + 1 < argc) {
+            benchmark_frames = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--synthetic" && i + 1 < argc) {
+            synthetic_cams = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--assert-zero-alloc") {
+            assert_zero_alloc = true;
+        } else {
+            cerr << "usage: " << argv[0]
+                 << " [--occluders <mesh.obj>] [--trajectory <tracks.csv>] [--on-demand]"
+                    " [--fps <max>] [--trails <samples>] [--benchmark <frames>]"
+                    " [--synthetic <cameras>] [--assert-zero-alloc]"
+                 << endl;
+            exit(EXIT_FAILURE);
         }
-        glm::vec3 xyz(j["xyz"][0], j["xyz"][2], j["xyz"][1]);
-        glm::vec3 pry(j["pry"][0], j["pry"][1], j["pry"][2]);
-        res.push_back(Camera(j["cam-id"], xyz - offset, pry, j["fov"], j["width"], j["height"],
-                             j["near"], j["far"]));
     }
-    return res;
-}
-
-vector<Object> read_obj_config(const std::string file) {
-    ifstream file_handler(file);
-    if (!file_handler.is_open()) {
-        cerr << "reading config json fail!" << endl;
+    if (assert_zero_alloc && (benchmark_frames == 0 || !alloc_track::ENABLED)) {
+        cerr << "--assert-zero-alloc needs --benchmark and a FRUSTUMCAM_TRACK_ALLOC build" << endl;
         exit(EXIT_FAILURE);
     }
-    string json_data;
-    std::ostringstream json_oss;
-    json_oss << file_handler.rdbuf();
-    json_data = json_oss.str();
-    file_handler.close();
-
-    vector<Object> res;
-    for (auto &j : json::parse(json_data)) {
-        glm::vec3 xyz(j["xyz"][0], j["xyz"][2], j["xyz"][1]);
-        res.push_back(Object(j["obj-id"], xyz - offset));
-    }
-    return res;
-}
 
-int main() {
-    vector<Camera> cams = read_cam_config("../config/cam.json");
+    // every frame is drawn while benchmarking, whatever changed
+    if (benchmark_frames > 0)
+        on_demand = false;
+
+    vector<Camera> cams;
+    if (synthetic_cams > 0)
+        cams = synthetic::make_cameras(synthetic_cams,
+                                       synthetic::site_extent(synthetic_cams * 20));
+    else {
+        AllocScope alloc_scope("config load");
+        cams = read_cam_config("../config/cam.json", offset, &geo);
+    }
     if (cams.empty()) {
         cerr << "no camera object!" << endl;
         exit(EXIT_FAILURE);
     }
 
-    vector<Object> objs = read_obj_config("../config/object.json");
+    // recorded tracks replace the static objects
+    vector<Object> objs;
+    if (synthetic_cams > 0)
+        objs = synthetic::make_objects(synthetic_cams * 20,
+                                       synthetic::site_extent(synthetic_cams * 20));
+    else if (trajectory_file.empty()) {
+        AllocScope alloc_scope("config load");
+        objs = read_obj_config("../config/object.json", offset, &geo);
+    }
+
+    // buildings blocking the line of sight, in the same UTM frame as cam.json
+    Bvh occluders;
+    if (!occluder_file.empty()) {
+        AllocScope alloc_scope("config load");
+        occluders = Bvh(read_obj_mesh(occluder_file, offset));
+    }
 
     /**********************************************************/
     // OpenGL initialize
@@ -133,9 +234,13 @@ int main() {
     }
 
     glfwMakeContextCurrent(window);
+    if (benchmark_frames > 0)
+        glfwSwapInterval(0);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, mouse_cursor_callback);
     glfwSetScrollCallback(window, mouse_scroll_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     // Viewport 만들기
     int framebuf_width, framebuf_height;
@@ -152,158 +257,294 @@ int main() {
     // run
     /**********************************************************/
     Shader shader("../shaders/draw_point.glsl");
+    Shader coverage_shader("../shaders/draw_coverage.glsl");
+
+    glGenVertexArrays(1, &coverage_vao);
+    glGenBuffers(1, &coverage_vbo);
+    glGenTextures(1, &coverage_tex);
+
+    DrawBatch batch;
+    Picker picker(framebuf_width, framebuf_height);
+    DepthQuery depth_query;
+    vector<future<DepthSample>> depth_results;
+    Trails trails(trail_length);
+
+    unique_ptr<FrameBenchmark> bench;
+    if (benchmark_frames > 0)
+        bench.reset(new FrameBenchmark(benchmark_frames));
+    auto mark = [&](const char *stage) {
+        if (bench)
+            bench->stage(stage);
+    };
+
+    // the pick ids have no room for these, they are drawn but cannot be picked
+    size_t unpickable =
+        count_if(objs.begin(), objs.end(), [](const Object &obj) { return !pickable(obj.id); });
+
+    // projection and geometry generation run on the simulation thread from here on
+    Simulator sim(cams, std::move(objs), std::move(occluders));
+    if (!trajectory_file.empty()) {
+        AllocScope alloc_scope("config load");
+        Trajectories traj = read_trajectory(trajectory_file, offset);
+        for (size_t t = 0; t < traj.tracks(); t++)
+            unpickable += !pickable(traj.track_id(t));
+        sim.set_trajectories(std::move(traj));
+    }
+    if (unpickable)
+        cerr << unpickable << " objects have ids outside [0, 2^30) and cannot be picked" << endl;
+    simulator = &sim;
+    // wakes the event wait below from the simulation thread
+    sim.set_on_publish([] { glfwPostEmptyEvent(); });
+    sim.start();
+    // keep the simulation busy while benchmarking a recording
+    if (bench && sim.has_trajectories())
+        sim.toggle_play();
+
+    auto frame_period = chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::duration<double>(max_fps > 0 ? 1.0 / max_fps : 0.0));
+    auto last_draw = chrono::steady_clock::now();
+    uint64_t shown_seq = 0;
+
+    while (!glfwWindowShouldClose(window) && !(bench && bench->done())) {
+        if (bench)
+            bench->begin_frame();
+
+        bool queries = pick_requested || picker.busy() || depth_requested || depth_query.busy();
+        if (on_demand && !redraw && !queries)
+            glfwWaitEventsTimeout(IDLE_TIMEOUT);
+        else
+            glfwPollEvents();
+        mark("events");
+
+        // input of the last frame, applied in one go
+        bool changed = control.update();
+        changed |= sim.acquire();
+        changed |= redraw || pick_requested || picker.busy() || depth_requested ||
+                   depth_query.busy();
+        redraw = false;
+        if (on_demand && !changed)
+            continue;
+        mark("update");
+
+        if (frame_period.count() > 0)
+            this_thread::sleep_until(last_draw + frame_period);
+        last_draw = chrono::steady_clock::now();
 
-    glGenVertexArrays(3, vao);
-    glGenBuffers(3, vbo);
-
-    while (!glfwWindowShouldClose(window)) {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         glEnable(GL_DEPTH_TEST);
         glDepthMask(GL_TRUE);
 
+        const glm::mat4 &mvp = control.get_mvp();
         shader.use();
-        shader.set_mat4("mvp", control.get_projection() * control.get_view() * control.get_model());
-
-        draw_grid_xz(10.f, 1.f);
-        // draw_plane_xz(10.f);
-
-        for (const auto &obj : objs)
-            draw_object(obj, glm::vec3(1, 0, 1));
-
-        for (const auto &cam : cams) {
-            draw_camera(cam, glm::vec3(1, 0.647059, 0));
-            projection::run(objs, cam.get_mvp(), cam.width_, cam.height_);
-            float px_x = 1532.f;
-            float px_y = cam.height_ - 1055.f;
-            for (float z = 0; z <= 1.f; z += 0.1) {
-                vector<GLfloat> pose =
-                    projection::introjection(glm::vec3(px_x, z, px_y), cam.get_mvp(), cam.width_,
-                                             cam.height_, cam.far_, cam.near_);
-                pose.push_back(1);
-                pose.push_back(0.647059);
-                pose.push_back(0);
-                point.insert(point.end(), pose.begin(), pose.end());
+        shader.set_mat4("mvp", mvp);
+
+        const Frame &frame = sim.frame();
+
+        batch.upload(frame);
+        batch.draw(shader);
+        mark("geometry");
+
+        if (trail_length > 0) {
+            trails.push(frame);
+            trails.draw(mvp, glm::vec3(1.f, 0.8f, 0.2f));
+        }
+        mark("trails");
+
+        coverage_shader.use();
+        coverage_shader.set_mat4("mvp", mvp);
+        bind_coverage_opengl(frame, coverage_shader);
+        mark("coverage");
+
+        // the scene depth is complete here, read it before the picking pass rebinds targets
+        if (depth_requested) {
+            int win_width, win_height;
+            glfwGetWindowSize(window, &win_width, &win_height);
+            glfwGetFramebufferSize(window, &framebuf_width, &framebuf_height);
+            depth_results.push_back(
+                depth_query.request((int)(depth_x * framebuf_width / win_width),
+                                    (int)((win_height - depth_y) * framebuf_height / win_height)));
+            depth_requested = false;
+        }
+        depth_query.capture(mvp, framebuf_width, framebuf_height);
+        depth_query.resolve();
+        for (size_t i = 0; i < depth_results.size();) {
+            if (depth_results[i].wait_for(chrono::seconds(0)) != future_status::ready) {
+                i++;
+                continue;
             }
+            print_depth(depth_results[i].get());
+            depth_results.erase(depth_results.begin() + i);
+        }
+        mark("depth");
+
+        if (pick_requested) {
+            int win_width, win_height;
+            glfwGetWindowSize(window, &win_width, &win_height);
+            glfwGetFramebufferSize(window, &framebuf_width, &framebuf_height);
+            picker.resize(framebuf_width, framebuf_height);
+            picker.request((int)(pick_x * framebuf_width / win_width),
+                           (int)((win_height - pick_y) * framebuf_height / win_height));
+            pick_requested = false;
+        }
+        picker.render(frame, mvp);
+        glViewport(0, 0, framebuf_width, framebuf_height);
+
+        GLuint pick;
+        if (picker.poll(pick))
+            print_pick(pick, frame);
+        mark("picking");
+
+        if (frame.seq != shown_seq && !std::isnan(frame.time)) {
+            char title[64];
+            snprintf(title, sizeof(title), "Viewer  t = %.3f", frame.time);
+            glfwSetWindowTitle(window, title);
+            shown_seq = frame.seq;
         }
-
-        bind_line_opengl();
-        bind_point_opengl();
-        bind_plane_opengl();
 
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        mark("swap");
+        if (bench)
+            bench->end_frame();
+    }
+    sim.stop();
+    simulator = nullptr;
+
+    if (bench) {
+        nlohmann::json summary = bench->summary();
+        summary["cameras"] = cams.size();
+        summary["framebuffer"] = {framebuf_width, framebuf_height};
+        cout << summary.dump(2) << endl;
     }
-    glDeleteVertexArrays(1, vao);
-    glDeleteBuffers(1, vbo);
+    uint64_t frame_allocs = bench ? bench->allocs() : 0;
+    bench.reset();
+
+    glDeleteVertexArrays(1, &coverage_vao);
+    glDeleteBuffers(1, &coverage_vbo);
+    glDeleteTextures(1, &coverage_tex);
 
     glfwTerminate();
 
+    if (assert_zero_alloc && frame_allocs > 0) {
+        cerr << frame_allocs << " heap allocations in steady-state frames" << endl;
+        return EXIT_FAILURE;
+    }
     return EXIT_SUCCESS;
 }
 
-void bind_line_opengl() {
-    glBindVertexArray(vao[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
-
-    glBufferData(GL_ARRAY_BUFFER, line.size() * sizeof(GLfloat), &line.front(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+void bind_coverage_opengl(const Frame &frame, Shader &shader) {
+    AllocScope alloc_scope("upload");
+    const CoverageGrid &grid = frame.coverage;
+    if (grid.tiles() == 0)
+        return;
+
+    int tiles = grid.tiles();
+    int texels = tiles * COVERAGE_TILE;
+    glBindTexture(GL_TEXTURE_2D, coverage_tex);
+
+    // (re)allocate when the grid changes shape, then upload only the tiles that moved
+    if (coverage_uploaded.size() != (size_t)tiles * tiles) {
+        coverage_uploaded.assign((size_t)tiles * tiles, ~uint64_t(0));
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, texels, texels, 0, GL_RED_INTEGER,
+                     GL_UNSIGNED_SHORT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        float extent = -grid.size() + texels * grid.step();
+        GLfloat quad[] = {-grid.size(), -0.01f, -grid.size(), extent, -0.01f, -grid.size(),
+                          -grid.size(), -0.01f, extent,       extent, -0.01f, extent};
+        glBindVertexArray(coverage_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, coverage_vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(0);
+    }
 
-    glDrawArrays(GL_LINES, 0, line.size() / 6);
+    bool changed = false;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    for (int tz = 0; tz < tiles; tz++) {
+        for (int tx = 0; tx < tiles; tx++) {
+            uint64_t &uploaded = coverage_uploaded[tz * tiles + tx];
+            if (uploaded == grid.tile_version(tx, tz))
+                continue;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, tx * COVERAGE_TILE, tz * COVERAGE_TILE,
+                            COVERAGE_TILE, COVERAGE_TILE, GL_RED_INTEGER, GL_UNSIGNED_SHORT,
+                            grid.tile(tx, tz));
+            uploaded = grid.tile_version(tx, tz);
+            changed = true;
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (changed)
+        coverage_max = max<float>(1.f, grid.max_count());
+
+    shader.set_int("coverage", 0);
+    shader.set_float("size", grid.size());
+    shader.set_float("step", grid.step());
+    shader.set_float("max_count", coverage_max);
+    shader.set_float("alpha", 0.5f);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(coverage_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
 }
 
-void bind_point_opengl() {
-    glBindVertexArray(vao[1]);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
-
-    glBufferData(GL_ARRAY_BUFFER, point.size() * sizeof(GLfloat), &point.front(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glPointSize(15);
-    glDrawArrays(GL_POINTS, 0, point.size() / 6);
-    glBindVertexArray(0);
+// in the frame of the config files
+glm::dvec3 config_pos(const glm::vec3 &world) {
+    return geo.geodetic ? world_to_llh(world, offset, geo) : world_to_utm(world, offset);
 }
 
-void bind_plane_opengl() {
-    glBindVertexArray(vao[2]);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[2]);
-
-    glBufferData(GL_ARRAY_BUFFER, plane.size() * sizeof(GLfloat), &plane.front(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, plane.size() / 6);
-    glBindVertexArray(0);
-}
-
-void draw_grid_xz(float size, float step) {
-    for (float i = step; i <= size; i += step) {
-        vector<GLfloat> v1{-size, 0, i, 1.f, 1.f, 1.f,
-                           size,  0, i, 1.f, 1.f, 1.f}; // lines parallel to X-axis
-        vector<GLfloat> v2{-size, 0, -i, 1.f, 1.f, 1.f,
-                           size,  0, -i, 1.f, 1.f, 1.f}; // lines parallel to X-axis
-
-        vector<GLfloat> v3{i, 0, -size, 1.f, 1.f, 1.f,
-                           i, 0, size,  1.f, 1.f, 1.f}; // lines parallel to Z-axis
-        vector<GLfloat> v4{-i, 0, -size, 1.f, 1.f, 1.f,
-                           -i, 0, size,  1.f, 1.f, 1.f}; // lines parallel to Z-axis
-
-        line.insert(line.end(), v1.begin(), v1.end());
-        line.insert(line.end(), v2.begin(), v2.end());
-        line.insert(line.end(), v3.begin(), v3.end());
-        line.insert(line.end(), v4.begin(), v4.end());
+void print_pick(GLuint pick, const Frame &frame) {
+    const vector<Object> &objs = frame.objects;
+    size_t index = pick & PICK_INDEX;
+    streamsize precision = cout.precision(geo.geodetic ? 10 : 9);
+    if ((pick & PICK_KIND) == PICK_CAMERA && index < frame.cameras.size()) {
+        // the pose the simulator drew the frame with, params hold z flipped from the world
+        const CameraParams &cam = frame.cameras[index];
+        glm::dvec3 pos = config_pos(glm::vec3(cam.pos.x, cam.pos.y, -cam.pos.z));
+        const glm::vec3 &pry = cam.pry;
+        cout << "camera " << cam.id << " at " << pos.x << ", " << pos.y << ", " << pos.z
+             << " pry " << pry.x << ", " << pry.y << ", " << pry.z << endl;
+        // line of sight from the visibility table of the same frame
+        cout << "  sees " << frame.visible_count(index) << " objects";
+        const char *sep = ": ";
+        for (int id : frame.visible(index)) {
+            cout << sep << id;
+            sep = ", ";
+        }
+        cout << endl;
+    } else if ((pick & PICK_KIND) == PICK_OBJECT) {
+        // the pick was rendered from an earlier frame, find the object by id in this one
+        auto it = find_if(objs.begin(), objs.end(),
+                          [&](const Object &obj) { return object_pick(obj.id) == pick; });
+        if (it != objs.end()) {
+            glm::dvec3 pos = config_pos(it->pt);
+            cout << "object " << it->id << " at " << pos.x << ", " << pos.y << ", " << pos.z
+                 << endl;
+        } else {
+            cout << "object " << index << " is gone" << endl;
+        }
+    } else {
+        cout << "nothing picked" << endl;
     }
-
-    // x-axis
-    vector<GLfloat> vx{0, 0, 0, 1.f, 0, 0, size,  0, 0, 1.f, 0,   0,
-                       0, 0, 0, 1.f, 0, 0, -size, 0, 0, 1.f, 1.f, 1.f};
-    line.insert(line.end(), vx.begin(), vx.end());
-
-    // z-axis
-    vector<GLfloat> vy{0, 0, 0, 0, 0, 1.f, 0, 0, size,  0,   0,   1.f,
-                       0, 0, 0, 0, 0, 1.f, 0, 0, -size, 1.f, 1.f, 1.f};
-    line.insert(line.end(), vy.begin(), vy.end());
+    cout.precision(precision);
 }
 
-void draw_plane_xz(float size) {
-    vector<GLfloat> v1{-size, 0, -size, 1.f, 1.f, 1.f};
-    vector<GLfloat> v2{size, 0, -size, 1.f, 1.f, 1.f};
-    vector<GLfloat> v3{size, 0, size, 1.f, 1.f, 1.f};
-    vector<GLfloat> v4{-size, 0, size, 1.f, 1.f, 1.f};
-
-    plane.insert(plane.end(), v1.begin(), v1.end());
-    plane.insert(plane.end(), v2.begin(), v2.end());
-    plane.insert(plane.end(), v3.begin(), v3.end());
-    plane.insert(plane.end(), v4.begin(), v4.end());
-}
-
-void draw_camera(Camera cam, glm::vec3 cam_color) {
-    vector<GLfloat> pose = cam.get_pose();
-    pose.push_back(cam_color.x);
-    pose.push_back(cam_color.y);
-    pose.push_back(cam_color.z);
-    point.insert(point.end(), pose.begin(), pose.end());
-
-    vector<GLfloat> frustum = cam.get_frustum();
-    line.insert(line.end(), frustum.begin(), frustum.end());
+void print_depth(const DepthSample &sample) {
+    if (!sample.hit) {
+        cout << "nothing drawn at " << sample.px.x << ", " << sample.px.y << endl;
+        return;
+    }
+    glm::dvec3 pos = config_pos(sample.world);
+    streamsize precision = cout.precision(geo.geodetic ? 10 : 9);
+    cout << "depth " << sample.linear << " at " << pos.x << ", " << pos.y << ", " << pos.z
+         << endl;
+    cout.precision(precision);
 }
-
-void draw_object(Object obj, glm::vec3 obj_color) {
-    vector<GLfloat> pose{obj.pt.x, obj.pt.y, obj.pt.z};
-    pose.push_back(obj_color.x);
-    pose.push_back(obj_color.y);
-    pose.push_back(obj_color.z);
-    point.insert(point.end(), pose.begin(), pose.end());
-}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "mesh.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "config.hpp"
+
+using namespace std;
+
+Mesh read_obj_mesh(const std::string &file, const glm::dvec3 &offset) {
+    ifstream file_handler(file);
+    if (!file_handler.is_open()) {
+        cerr << "reading mesh obj fail!" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    Mesh res;
+    string line, tag, ref;
+    vector<int> poly;
+    while (getline(file_handler, line)) {
+        istringstream iss(line);
+        if (!(iss >> tag))
+            continue;
+
+        if (tag == "v") {
+            glm::dvec3 utm;
+            iss >> utm.x >> utm.y >> utm.z;
+            res.vertex.push_back(utm_to_world(utm, offset));
+        } else if (tag == "f") {
+            // `i`, `i/t`, `i//n` or `i/t/n`, negative indices count from the end
+            poly.clear();
+            while (iss >> ref) {
+                int idx = atoi(ref.c_str());
+                idx = idx < 0 ? (int)res.vertex.size() + idx : idx - 1;
+                if (idx < 0 || idx >= (int)res.vertex.size()) {
+                    cerr << "invalid face in mesh obj: " << line << endl;
+                    exit(EXIT_FAILURE);
+                }
+                poly.push_back(idx);
+            }
+            for (size_t k = 2; k < poly.size(); k++)
+                res.face.push_back(glm::ivec3(poly[0], poly[k - 1], poly[k]));
+        }
+    }
+    return res;
+}
@@ -0,0 +1,21 @@
+#ifndef __MESH_HPP__
+#define __MESH_HPP__
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Static triangle soup, e.g. the buildings of a site, in scene world coordinates.
+struct Mesh {
+    std::vector<glm::vec3> vertex;
+    std::vector<glm::ivec3> face;
+
+    bool empty() const { return face.empty(); }
+};
+
+// Wavefront OBJ with `v` positions in UTM (easting, northing, height) like cam.json.
+// Polygons are fanned into triangles, everything but `v` and `f` is ignored.
+Mesh read_obj_mesh(const std::string &file, const glm::dvec3 &offset);
+
+#endif
@@ -0,0 +1,282 @@
+#include "overlap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// clipping a hexahedron by 6 planes adds at most one face per plane and one vertex per face
+// and plane, so fixed capacities keep the narrow phase free of heap allocations
+constexpr int MAX_FACES = 12;
+constexpr int MAX_VERTS = 12;
+
+struct Polygon {
+    glm::vec3 v[MAX_VERTS];
+    int n = 0;
+
+    void push(const glm::vec3 &p) {
+        if (n < MAX_VERTS)
+            v[n++] = p;
+    }
+};
+
+struct Polyhedron {
+    Polygon face[MAX_FACES];
+    int n = 0;
+};
+
+// 6 unique edge directions of a frustum: 2 along the near / far rectangles, 4 lateral
+constexpr int EDGE_DIRS[6][2] = {{0, 1}, {0, 2}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+constexpr float SAT_EPSILON = 1e-5f;
+
+void to_polyhedron(const Frustum &f, Polyhedron &res) {
+    res.n = 6;
+    for (int i = 0; i < 6; i++) {
+        res.face[i].n = 0;
+        for (int k = 0; k < 4; k++)
+            res.face[i].push(f[FRUSTUM_FACES[i][k]]);
+    }
+}
+
+// keep the part of the convex polyhedron inside the plane and close it with a cap face
+void clip(const Polyhedron &poly, const Plane &plane, Polyhedron &res) {
+    // every crossing edge is shared by two faces, so the cap collects each point twice
+    glm::vec3 cap[2 * MAX_FACES];
+    int n_cap = 0;
+
+    res.n = 0;
+    for (int f = 0; f < poly.n; f++) {
+        const Polygon &face = poly.face[f];
+        Polygon &clipped = res.face[res.n];
+        clipped.n = 0;
+        for (int i = 0; i < face.n; i++) {
+            const glm::vec3 &a = face.v[i];
+            const glm::vec3 &b = face.v[(i + 1) % face.n];
+            float da = glm::dot(plane.n, a) - plane.d;
+            float db = glm::dot(plane.n, b) - plane.d;
+
+            if (da <= 0)
+                clipped.push(a);
+            if ((da <= 0) != (db <= 0)) {
+                glm::vec3 p = a + (b - a) * (da / (da - db));
+                clipped.push(p);
+                if (n_cap < 2 * MAX_FACES)
+                    cap[n_cap++] = p;
+            }
+        }
+        if (clipped.n >= 3 && res.n + 1 < MAX_FACES)
+            res.n++;
+    }
+
+    if (n_cap >= 3) {
+        glm::vec3 center(0);
+        for (int i = 0; i < n_cap; i++)
+            center += cap[i];
+        center /= (float)n_cap;
+
+        glm::vec3 u = fabs(plane.n.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+        u = glm::normalize(glm::cross(plane.n, u));
+        glm::vec3 v = glm::cross(plane.n, u);
+        float angle[2 * MAX_FACES];
+        for (int i = 0; i < n_cap; i++)
+            angle[i] = atan2f(glm::dot(cap[i] - center, v), glm::dot(cap[i] - center, u));
+
+        // insertion sort by angle, dropping the duplicate of every point
+        Polygon &face = res.face[res.n];
+        face.n = 0;
+        int order[2 * MAX_FACES];
+        for (int i = 0; i < n_cap; i++) {
+            int k = i;
+            while (k > 0 && angle[order[k - 1]] > angle[i]) {
+                order[k] = order[k - 1];
+                k--;
+            }
+            order[k] = i;
+        }
+        for (int i = 0; i < n_cap; i++) {
+            const glm::vec3 &p = cap[order[i]];
+            if (face.n == 0 || glm::distance(face.v[face.n - 1], p) > 1e-6f)
+                face.push(p);
+        }
+        if (face.n >= 3)
+            res.n++;
+    }
+}
+
+float volume(const Polyhedron &poly) {
+    glm::vec3 ref(0);
+    int count = 0;
+    for (int f = 0; f < poly.n; f++) {
+        for (int i = 0; i < poly.face[f].n; i++)
+            ref += poly.face[f].v[i];
+        count += poly.face[f].n;
+    }
+    if (count == 0)
+        return 0;
+    ref /= (float)count;
+
+    // fan every face into tetrahedra around an interior point
+    float res = 0;
+    for (int f = 0; f < poly.n; f++) {
+        const Polygon &face = poly.face[f];
+        for (int i = 1; i + 1 < face.n; i++)
+            res += fabs(glm::dot(face.v[0] - ref,
+                                 glm::cross(face.v[i] - ref, face.v[i + 1] - ref)));
+    }
+    return res / 6.f;
+}
+
+void interval(const Frustum &f, const glm::vec3 &axis, float &lo, float &hi) {
+    lo = hi = glm::dot(axis, f[0]);
+    for (size_t i = 1; i < f.size(); i++) {
+        float p = glm::dot(axis, f[i]);
+        lo = min(lo, p);
+        hi = max(hi, p);
+    }
+}
+
+bool separates(const Frustum &a, const Frustum &b, glm::vec3 axis) {
+    float len = glm::length(axis);
+    if (len < 1e-6f)
+        return false;
+    axis /= len;
+
+    float a_lo, a_hi, b_lo, b_hi;
+    interval(a, axis, a_lo, a_hi);
+    interval(b, axis, b_lo, b_hi);
+    return a_hi < b_lo - SAT_EPSILON || b_hi < a_lo - SAT_EPSILON;
+}
+} // namespace
+
+float OverlapMatrix::at(int i, int j) const {
+    if (i > j)
+        swap(i, j);
+    if (i < 0 || (size_t)i + 1 >= row.size())
+        return 0;
+    auto begin = col.begin() + row[i];
+    auto end = col.begin() + row[i + 1];
+    auto it = lower_bound(begin, end, j);
+    return it != end && *it == j ? volume[it - col.begin()] : 0;
+}
+
+namespace overlap {
+
+Aabb bounds(const Frustum &f) { return frustum_bounds(f); }
+
+float volume(const Frustum &f) {
+    Polyhedron poly;
+    to_polyhedron(f, poly);
+    return ::volume(poly);
+}
+
+vector<pair<int, int>> sweep_and_prune(Span<const Aabb> boxes) {
+    // sweep along the axis the box centres spread the most, so the active list stays short
+    glm::vec3 lo(INFINITY), hi(-INFINITY);
+    for (const Aabb &box : boxes) {
+        lo = glm::min(lo, box.min + box.max);
+        hi = glm::max(hi, box.min + box.max);
+    }
+    glm::vec3 spread = hi - lo;
+    int s = 0;
+    for (int a = 1; a < 3; a++)
+        if (spread[a] > spread[s])
+            s = a;
+    int u = (s + 1) % 3, v = (s + 2) % 3;
+
+    vector<int> order(boxes.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = (int)i;
+    sort(order.begin(), order.end(),
+         [&](int a, int b) { return boxes[a].min[s] < boxes[b].min[s]; });
+
+    vector<pair<int, int>> res;
+    vector<int> active;
+    for (int i : order) {
+        const Aabb &box = boxes[i];
+        for (size_t k = 0; k < active.size();) {
+            const Aabb &other = boxes[active[k]];
+            if (other.max[s] < box.min[s]) {
+                active[k] = active.back();
+                active.pop_back();
+                continue;
+            }
+            if (other.min[u] <= box.max[u] && box.min[u] <= other.max[u] &&
+                other.min[v] <= box.max[v] && box.min[v] <= other.max[v])
+                res.emplace_back(min(i, active[k]), max(i, active[k]));
+            k++;
+        }
+        active.push_back(i);
+    }
+    sort(res.begin(), res.end());
+    return res;
+}
+
+bool separated(const Frustum &a, const FrustumPlanes &pa, const Frustum &b,
+               const FrustumPlanes &pb) {
+    for (int i = 0; i < 6; i++)
+        if (separates(a, b, pa[i].n) || separates(a, b, pb[i].n))
+            return true;
+
+    for (const auto &ea : EDGE_DIRS) {
+        glm::vec3 da = a[ea[1]] - a[ea[0]];
+        for (const auto &eb : EDGE_DIRS)
+            if (separates(a, b, glm::cross(da, b[eb[1]] - b[eb[0]])))
+                return true;
+    }
+    return false;
+}
+
+float intersection_volume(const Frustum &a, const FrustumPlanes &pb) {
+    Polyhedron poly[2];
+    to_polyhedron(a, poly[0]);
+    int cur = 0;
+    for (const auto &plane : pb) {
+        clip(poly[cur], plane, poly[cur ^ 1]);
+        cur ^= 1;
+        if (poly[cur].n == 0)
+            return 0;
+    }
+    return ::volume(poly[cur]);
+}
+
+OverlapMatrix run(Span<const Camera> cams, Scheduler &scheduler, size_t grain) {
+    size_t n = cams.size();
+    // cached on the cameras, gathered for locality in the pair loop
+    vector<Frustum> frusta(n);
+    vector<FrustumPlanes> planes(n);
+    vector<Aabb> boxes(n);
+    for (size_t i = 0; i < n; i++) {
+        frusta[i] = cams[i].get_frustum();
+        planes[i] = cams[i].get_planes();
+        boxes[i] = cams[i].get_bounds();
+    }
+
+    vector<pair<int, int>> pairs = sweep_and_prune(boxes);
+    vector<float> volumes(pairs.size());
+    scheduler.parallel_for(0, pairs.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            int i = pairs[k].first, j = pairs[k].second;
+            volumes[k] = separated(frusta[i], planes[i], frusta[j], planes[j])
+                             ? 0
+                             : intersection_volume(frusta[i], planes[j]);
+        }
+    });
+
+    // pairs are sorted by (i, j), so the CSR rows fill in order
+    OverlapMatrix res;
+    res.row.assign(n + 1, 0);
+    for (size_t k = 0; k < pairs.size(); k++) {
+        if (volumes[k] <= 0)
+            continue;
+        res.row[pairs[k].first + 1]++;
+        res.col.push_back(pairs[k].second);
+        res.volume.push_back(volumes[k]);
+    }
+    for (size_t i = 0; i < n; i++)
+        res.row[i + 1] += res.row[i];
+    return res;
+}
+} // namespace overlap
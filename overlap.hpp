@@ -0,0 +1,44 @@
+#ifndef __OVERLAP_HPP__
+#define __OVERLAP_HPP__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "camera.hpp"
+#include "frustum.hpp"
+#include "scheduler.hpp"
+#include "span.hpp"
+
+// Sparse symmetric overlap matrix, upper triangle (i < j) in CSR form.
+// Cameras are referred to by their index in the input list.
+struct OverlapMatrix {
+    std::vector<size_t> row; // n + 1 entries, pairs of camera i are [row[i], row[i + 1])
+    std::vector<int> col;
+    std::vector<float> volume;
+
+    size_t nonzeros() const { return col.size(); }
+    float at(int i, int j) const;
+};
+
+namespace overlap {
+
+Aabb bounds(const Frustum &f);
+float volume(const Frustum &f);
+// broad phase: sweep and prune along the axis the boxes spread the most along, returns every
+// pair (i < j) whose boxes intersect
+std::vector<std::pair<int, int>> sweep_and_prune(Span<const Aabb> boxes);
+
+// narrow phase, with the frusta's planes as from frustum_planes() / Camera::get_planes()
+bool separated(const Frustum &a, const FrustumPlanes &pa, const Frustum &b,
+               const FrustumPlanes &pb);
+// volume of a clipped by the planes pb of the other frustum
+float intersection_volume(const Frustum &a, const FrustumPlanes &pb);
+
+// overlap volume of every intersecting frustum pair, candidate pairs run as tasks of `grain`
+OverlapMatrix run(Span<const Camera> cams, Scheduler &scheduler, size_t grain = 64);
+} // namespace overlap
+
+#endif
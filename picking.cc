@@ -0,0 +1,153 @@
+#include "picking.hpp"
+
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+Picker::Picker(int width, int height)
+    : shader_("../shaders/draw_pick.glsl"), fence_(nullptr), width_(0), height_(0),
+      requested_(false) {
+    glGenFramebuffers(1, &fbo_);
+    glGenTextures(1, &color_);
+    glGenRenderbuffers(1, &depth_);
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(2, vbo_);
+
+    glGenBuffers(1, &pbo_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_);
+    int side = 2 * PICK_RADIUS + 1;
+    glBufferData(GL_PIXEL_PACK_BUFFER, side * side * sizeof(GLuint), nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // positions share the point layout of Frame, ids come from a second buffer
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_[0]);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_[1]);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void *)0);
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+
+    resize(width, height);
+}
+
+Picker::~Picker() {
+    if (fence_)
+        glDeleteSync(fence_);
+    glDeleteBuffers(1, &pbo_);
+    glDeleteBuffers(2, vbo_);
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteRenderbuffers(1, &depth_);
+    glDeleteTextures(1, &color_);
+    glDeleteFramebuffers(1, &fbo_);
+}
+
+void Picker::resize(int width, int height) {
+    if (width == width_ && height == height_)
+        return;
+    width_ = width;
+    height_ = height;
+
+    glBindTexture(GL_TEXTURE_2D, color_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT,
+                 nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Picker::request(int x, int y) {
+    requested_ = true;
+    x_ = x;
+    y_ = y;
+}
+
+void Picker::render(const Frame &frame, const glm::mat4 &mvp) {
+    // one pick in flight at a time
+    if (!requested_ || fence_)
+        return;
+    requested_ = false;
+
+    read_cx_ = x_;
+    read_cy_ = y_;
+    read_x_ = max(0, x_ - PICK_RADIUS);
+    read_y_ = max(0, y_ - PICK_RADIUS);
+    read_w_ = min(width_, x_ + PICK_RADIUS + 1) - read_x_;
+    read_h_ = min(height_, y_ + PICK_RADIUS + 1) - read_y_;
+    if (read_w_ <= 0 || read_h_ <= 0)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_[0]);
+    glBufferData(GL_ARRAY_BUFFER, frame.point.size() * sizeof(GLfloat), frame.point.data(),
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_[1]);
+    glBufferData(GL_ARRAY_BUFFER, frame.point_id.size() * sizeof(GLuint), frame.point_id.data(),
+                 GL_STREAM_DRAW);
+
+    // only the pixels around the cursor are cleared, shaded and read
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, width_, height_);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(read_x_, read_y_, read_w_, read_h_);
+
+    const GLuint zero[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, zero);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    shader_.use();
+    shader_.set_mat4("mvp", mvp);
+    glBindVertexArray(vao_);
+    glPointSize(15);
+    glDrawArrays(GL_POINTS, 0, frame.point_id.size());
+    glBindVertexArray(0);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(read_x_, read_y_, read_w_, read_h_, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool Picker::poll(GLuint &id) {
+    if (!fence_)
+        return false;
+    GLenum state = glClientWaitSync(fence_, 0, 0);
+    if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED)
+        return false;
+    glDeleteSync(fence_);
+    fence_ = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_);
+    const GLuint *ids = static_cast<const GLuint *>(glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, read_w_ * read_h_ * sizeof(GLuint), GL_MAP_READ_BIT));
+
+    // closest hit to the cursor
+    id = 0;
+    int best = INT_MAX;
+    for (int y = 0; ids && y < read_h_; y++) {
+        for (int x = 0; x < read_w_; x++) {
+            GLuint v = ids[y * read_w_ + x];
+            int dx = read_x_ + x - read_cx_, dy = read_y_ + y - read_cy_;
+            if (v != 0 && dx * dx + dy * dy < best) {
+                best = dx * dx + dy * dy;
+                id = v;
+            }
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef __PICKING_HPP__
+#define __PICKING_HPP__
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "frame.hpp"
+#include "shader.hpp"
+
+// half size of the pixel window searched around the cursor
+constexpr int PICK_RADIUS = 4;
+
+// GPU picking. On request the frame's points are drawn with their pick ids into an R32UI
+// attachment, restricted by scissor to a small window around the cursor. That window is read
+// back through a pixel buffer behind a fence, so neither side ever stalls on the GPU.
+class Picker {
+  public:
+    Picker(int width, int height);
+    ~Picker();
+
+    void resize(int width, int height);
+
+    // queue a pick at framebuffer pixel (x, y counted from the bottom)
+    void request(int x, int y);
+    // draw the id pass for a queued pick and start its readback
+    void render(const Frame &frame, const glm::mat4 &mvp);
+    // true once a started readback completed. id is the pick id closest to the cursor, 0 when
+    // nothing was hit
+    bool poll(GLuint &id);
+    // a pick is queued or its readback has not been collected yet
+    bool busy() const { return requested_ || fence_ != nullptr; }
+
+  private:
+    Shader shader_;
+
+    GLuint fbo_;
+    GLuint color_;
+    GLuint depth_;
+    GLuint vao_;
+    GLuint vbo_[2];
+    GLuint pbo_;
+    GLsync fence_;
+
+    int width_;
+    int height_;
+
+    bool requested_;
+    int x_;
+    int y_;
+
+    // region being read back and the cursor it was requested at
+    int read_cx_;
+    int read_cy_;
+    int read_x_;
+    int read_y_;
+    int read_w_;
+    int read_h_;
+};
+
+#endif
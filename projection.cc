@@ -0,0 +1,67 @@
+#include "projection.hpp"
+
+#include <cassert>
+#include <cmath>
+
+using namespace std;
+
+namespace projection {
+
+size_t run(Span<const Object> objects, const glm::mat4 &mvp, int w, int h,
+           Span<ProjectedPoint> out) {
+    assert(out.size() >= objects.size());
+    int viewport[4] = {0, 0, w, h};
+
+    size_t visible = 0;
+    for (size_t i = 0; i < objects.size(); i++) {
+        const Object &obj = objects[i];
+        glm::vec4 pos(obj.pt, 1.f);
+        glm::vec4 ndc = mvp * pos;
+        bool in_front = ndc.w > 0;
+        ndc /= ndc.w;
+
+        double winX, winY, winZ; // 2D point
+        winX = viewport[2] * (ndc.x + 1) / 2 + viewport[0];
+        winY = (ndc.z + 1) / 2;
+        winZ = viewport[3] * (ndc.y + 1) / 2 + viewport[1];
+
+        ProjectedPoint &res = out[i];
+        res.id = obj.id;
+        res.win = glm::vec3(winX, winY, winZ);
+        res.visible = in_front && fabs(ndc.x) <= 1.f && fabs(ndc.y) <= 1.f && fabs(ndc.z) <= 1.f;
+        visible += res.visible;
+    }
+    return visible;
+};
+
+glm::vec3 introjection(const glm::vec3 &px, const glm::mat4 &mvp, int w, int h) {
+    // px.y is already the window depth, so the full mvp is all it takes. the viewer gets that
+    // depth from DepthQuery instead of a blocking glReadPixels per pixel
+    return unproject(px, glm::inverse(mvp), w, h);
+};
+
+void introjection(Span<const glm::vec3> px, const glm::mat4 &mvp, int w, int h,
+                  Span<glm::vec3> out) {
+    assert(out.size() >= px.size());
+    glm::mat4 inv_mvp = glm::inverse(mvp);
+
+    for (size_t i = 0; i < px.size(); i++)
+        out[i] = unproject(px[i], inv_mvp, w, h);
+}
+
+bool ground_intersection(const glm::vec2 &px, const glm::mat4 &inv_mvp, int w, int h,
+                         float ground, glm::vec3 &out) {
+    glm::vec3 near = unproject(glm::vec3(px.x, 0.f, px.y), inv_mvp, w, h);
+    glm::vec3 far = unproject(glm::vec3(px.x, 1.f, px.y), inv_mvp, w, h);
+    glm::vec3 dir = far - near;
+
+    if (fabs(dir.y) < 1e-9f)
+        return false;
+    float t = (ground - near.y) / dir.y;
+    if (t < 0)
+        return false;
+
+    out = near + t * dir;
+    return true;
+}
+} // namespace projection
@@ -0,0 +1,142 @@
+#include "scheduler.hpp"
+
+using namespace std;
+
+namespace {
+thread_local const Scheduler *tls_owner = nullptr;
+thread_local size_t tls_worker = 0;
+} // namespace
+
+Scheduler::Scheduler(size_t workers) : queued_(0), stop_(false) {
+    // the last queue belongs to whichever thread submits from outside the pool
+    for (size_t i = 0; i < workers + 1; i++)
+        queues_.push_back(make_unique<Queue>());
+
+    for (size_t i = 0; i < workers; i++)
+        threads_.emplace_back(&Scheduler::worker, this, i);
+}
+
+Scheduler::~Scheduler() {
+    {
+        lock_guard<mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &t : threads_)
+        t.join();
+}
+
+size_t Scheduler::this_worker() const {
+    return tls_owner == this ? tls_worker : queues_.size() - 1;
+}
+
+void Scheduler::Queue::push_back(const Task &task) {
+    if (count == ring.size()) {
+        vector<Task> grown(max<size_t>(16, ring.size() * 2));
+        for (size_t i = 0; i < count; i++)
+            grown[i] = ring[(head + i) % ring.size()];
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + count) % ring.size()] = task;
+    count++;
+}
+
+bool Scheduler::Queue::pop_front(Task &task) {
+    if (count == 0)
+        return false;
+    task = ring[head];
+    head = (head + 1) % ring.size();
+    count--;
+    return true;
+}
+
+bool Scheduler::Queue::pop_back(Task &task) {
+    if (count == 0)
+        return false;
+    task = ring[(head + count - 1) % ring.size()];
+    count--;
+    return true;
+}
+
+void Scheduler::submit(Batch &batch, size_t begin, size_t end, size_t grain) {
+    size_t chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1 || threads_.empty()) {
+        batch.run(batch.ctx, begin, end);
+        return;
+    }
+
+    // hand every queue a contiguous block of chunks, the owner walks its block front to back
+    // while thieves take from the far end
+    batch.pending = chunks;
+    size_t n_queues = queues_.size();
+    size_t self = this_worker();
+    for (size_t q = 0; q < n_queues; q++) {
+        size_t c0 = chunks * q / n_queues;
+        size_t c1 = chunks * (q + 1) / n_queues;
+        if (c0 == c1)
+            continue;
+        Queue &queue = *queues_[(self + q) % n_queues];
+        lock_guard<mutex> lock(queue.mutex);
+        for (size_t c = c0; c < c1; c++)
+            queue.push_back(Task{&batch, begin + c * grain, min(end, begin + (c + 1) * grain)});
+    }
+    queued_.fetch_add(chunks, memory_order_release);
+    {
+        lock_guard<mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_all();
+
+    // help out until every chunk of this batch has run
+    Task task;
+    while (batch.pending.load(memory_order_acquire) > 0) {
+        if (acquire(self, task))
+            execute(task);
+        else
+            this_thread::yield();
+    }
+}
+
+bool Scheduler::acquire(size_t self, Task &task) {
+    {
+        Queue &own = *queues_[self];
+        lock_guard<mutex> lock(own.mutex);
+        if (own.pop_front(task)) {
+            queued_.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues_.size(); i++) {
+        Queue &victim = *queues_[(self + i) % queues_.size()];
+        lock_guard<mutex> lock(victim.mutex);
+        if (victim.pop_back(task)) {
+            queued_.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::execute(const Task &task) {
+    Batch *batch = task.batch;
+    batch->run(batch->ctx, task.begin, task.end);
+    batch->pending.fetch_sub(1, memory_order_acq_rel);
+}
+
+void Scheduler::worker(size_t self) {
+    tls_owner = this;
+    tls_worker = self;
+
+    Task task;
+    while (true) {
+        if (acquire(self, task)) {
+            execute(task);
+            continue;
+        }
+
+        unique_lock<mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_.load(memory_order_acquire) > 0; });
+        if (stop_)
+            return;
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef __SCHEDULER_HPP__
+#define __SCHEDULER_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Small work-stealing thread pool.
+// Every worker owns a deque of range tasks: it pops from the front of its own deque and, once
+// that runs dry, steals from the back of the others. The thread calling parallel_for() gets a
+// deque of its own and works on the batch until it is finished, so nested calls are fine.
+// Only one non-worker thread may submit at a time.
+class Scheduler {
+  public:
+    explicit Scheduler(size_t workers = default_workers());
+    ~Scheduler();
+
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    // number of threads that may run tasks (workers + submitting thread)
+    size_t size() const { return queues_.size(); }
+    // slot of the calling thread in [0, size())
+    size_t this_worker() const;
+
+    // run fn(chunk_begin, chunk_end) over [begin, end) split into chunks of `grain` items
+    template <typename F> void parallel_for(size_t begin, size_t end, size_t grain, F &&fn) {
+        if (begin >= end)
+            return;
+        using Fn = typename std::remove_reference<F>::type;
+        Batch batch;
+        batch.ctx = const_cast<void *>(static_cast<const void *>(&fn));
+        batch.run = [](void *ctx, size_t b, size_t e) { (*static_cast<Fn *>(ctx))(b, e); };
+        submit(batch, begin, end, std::max<size_t>(grain, 1));
+    }
+
+    static size_t default_workers() {
+        size_t n = std::thread::hardware_concurrency();
+        return n > 1 ? n - 1 : 0;
+    }
+
+  private:
+    struct Batch {
+        void (*run)(void *ctx, size_t begin, size_t end);
+        void *ctx;
+        std::atomic<size_t> pending{0};
+    };
+
+    struct Task {
+        Batch *batch;
+        size_t begin;
+        size_t end;
+    };
+
+    // ring buffer deque, grows only when full so steady-state pushes do not allocate
+    struct Queue {
+        std::mutex mutex;
+        std::vector<Task> ring;
+        size_t head = 0;
+        size_t count = 0;
+
+        void push_back(const Task &task);
+        bool pop_front(Task &task);
+        bool pop_back(Task &task);
+    };
+
+    void submit(Batch &batch, size_t begin, size_t end, size_t grain);
+    bool acquire(size_t self, Task &task);
+    void execute(const Task &task);
+    void worker(size_t self);
+
+  private:
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> queued_;
+    bool stop_;
+};
+
+#endif
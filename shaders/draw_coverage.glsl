@@ -0,0 +1,43 @@
+#version 430 core
+
+#if defined(VERTEX_SHADER)
+
+layout(location = 0)in vec3 pos;
+
+uniform mat4 mvp;
+
+out vec2 ground;
+
+void main()
+{
+    gl_Position = mvp * vec4(pos, 1.0);
+    ground = pos.xz;
+}
+
+#elif defined(FRAGMENT_SHADER)
+
+out vec4 FragColor;
+in vec2 ground;
+
+// cell (x, z) of the coverage grid lives at texel (x, z)
+uniform usampler2D coverage;
+uniform float size;
+uniform float step;
+uniform float max_count;
+uniform float alpha;
+
+vec3 heat(float t)
+{
+    return clamp(vec3(1.5 - abs(4.0 * t - 3.0), 1.5 - abs(4.0 * t - 2.0), 1.5 - abs(4.0 * t - 1.0)), 0.0, 1.0);
+}
+
+void main()
+{
+    ivec2 cell = ivec2(floor((ground + size) / step));
+    uint count = texelFetch(coverage, cell, 0).r;
+    if (count == 0u)
+        discard;
+
+    FragColor = vec4(heat(float(count) / max_count), alpha);
+}
+#endif
@@ -0,0 +1,27 @@
+#version 430 core
+
+#if defined(VERTEX_SHADER)
+
+layout(location = 0)in vec3 pos;
+layout(location = 2)in uint id;
+
+uniform mat4 mvp;
+
+flat out uint pick_id;
+
+void main()
+{
+    gl_Position = mvp * vec4(pos, 1.0);
+    pick_id = id;
+}
+
+#elif defined(FRAGMENT_SHADER)
+
+layout(location = 0)out uint FragId;
+flat in uint pick_id;
+
+void main()
+{
+    FragId = pick_id;
+}
+#endif
@@ -20,6 +20,8 @@ void main()
 out vec4 FragColor;
 in vec3 in_color;
 
+uniform float alpha = 1.0;
+
 float near = 0.5;
 float far = 20.0;
 
@@ -31,7 +33,7 @@ float LinearizeDepth(float depth)
 
 void main()
 {
-    FragColor = vec4(in_color, 1.0);
+    FragColor = vec4(in_color, alpha);
     
     // float depth = LinearizeDepth(gl_FragCoord.z) / far;
     // FragColor = vec4(vec3(depth), 1.0);
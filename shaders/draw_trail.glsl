@@ -0,0 +1,53 @@
+#version 330 core
+
+#if defined(VERTEX_SHADER)
+
+// ring of `ring_length` layers, layer l of slot s at texel l * stride + s, w = 0 when absent
+uniform samplerBuffer history;
+uniform int head;
+uniform int ring_length;
+uniform int filled;
+uniform int stride;
+
+uniform mat4 mvp;
+
+out float fade;
+out float keep;
+
+vec4 sample_at(int slot, int age)
+{
+    int layer = (head - age + ring_length) % ring_length;
+    return texelFetch(history, layer * stride + slot);
+}
+
+void main()
+{
+    // vertex 2k and 2k + 1 are the ends of segment k, segment j of a slot spans ages j, j + 1
+    int segment = gl_VertexID / 2;
+    int slot = segment / (ring_length - 1);
+    int age = segment % (ring_length - 1);
+
+    vec4 a = sample_at(slot, age);
+    vec4 b = sample_at(slot, age + 1);
+    vec4 p = (gl_VertexID % 2) == 0 ? a : b;
+
+    gl_Position = mvp * vec4(p.xyz, 1.0);
+    keep = (age + 1 < filled && a.w > 0.0 && b.w > 0.0) ? 1.0 : 0.0;
+    fade = 1.0 - float(age + (gl_VertexID % 2)) / float(ring_length);
+}
+
+#elif defined(FRAGMENT_SHADER)
+
+out vec4 FragColor;
+in float fade;
+in float keep;
+
+uniform vec3 color;
+
+void main()
+{
+    if (keep < 0.5)
+        discard;
+    FragColor = vec4(color, fade);
+}
+#endif
@@ -0,0 +1,246 @@
+#include "simulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "alloc_track.hpp"
+
+using namespace std;
+
+Simulator::Simulator(vector<Camera> cams, vector<Object> objs, Bvh occluders, size_t grain)
+    : cams_(std::move(cams)), objs_(std::move(objs)), objs_revision_(1),
+      occluders_(std::move(occluders)), grain_(grain), dirty_(false), playing_(false), rate_(1),
+      time_(NAN), step_time_(NAN), seq_(0), running_(false) {
+    cam_frames_.resize(cams_.size());
+    cam_revision_.assign(cams_.size(), 0);
+    cam_params_.resize(cams_.size());
+    cam_visible_.resize(cams_.size());
+    cam_visible_revision_.assign(cams_.size(), 0);
+    cam_visible_objects_.assign(cams_.size(), 0);
+    arenas_.resize(scheduler_.size());
+
+    vector<Footprint> footprints;
+    footprints.reserve(cams_.size());
+    for (const auto &cam : cams_)
+        footprints.push_back(cam.get_footprint());
+    coverage_ = CoverageGrid(COVERAGE_SIZE, COVERAGE_STEP);
+    coverage_.rebuild(footprints, scheduler_);
+}
+
+Simulator::~Simulator() { stop(); }
+
+void Simulator::start() {
+    if (running_.exchange(true))
+        return;
+    worker_ = thread(&Simulator::loop, this);
+}
+
+void Simulator::stop() {
+    {
+        lock_guard<mutex> lock(pending_mutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+void Simulator::set_camera(size_t i, const Camera &cam) {
+    {
+        lock_guard<mutex> lock(pending_mutex_);
+        pending_.emplace_back(i, cam);
+        dirty_ = true;
+    }
+    wake_.notify_one();
+}
+
+void Simulator::apply_pending() {
+    vector<pair<size_t, Camera>> pending;
+    double t = NAN;
+    {
+        lock_guard<mutex> lock(pending_mutex_);
+        pending.swap(pending_);
+
+        if (!traj_.empty()) {
+            t = playback_time(chrono::steady_clock::now());
+            // stop at either end of the recording
+            if (playing_ && (t >= traj_.end() || t <= traj_.begin())) {
+                playing_ = false;
+                time_ = t;
+            }
+        }
+    }
+
+    if (!traj_.empty()) {
+        step_time_ = t;
+        traj_.sample(t, objs_);
+        objs_revision_++;
+    }
+
+    for (const auto &p : pending) {
+        if (p.first >= cams_.size())
+            continue;
+        coverage_.update(cams_[p.first].get_footprint(), p.second.get_footprint());
+        cams_[p.first] = p.second;
+    }
+}
+
+void Simulator::set_trajectories(Trajectories traj) {
+    lock_guard<mutex> lock(pending_mutex_);
+    traj_ = std::move(traj);
+    playing_ = false;
+    time_ = traj_.begin();
+    dirty_ = true;
+}
+
+double Simulator::playback_time(chrono::steady_clock::time_point now) const {
+    if (!playing_)
+        return time_;
+    double t = time_ + rate_ * chrono::duration<double>(now - wall_).count();
+    return clamp(t, traj_.begin(), traj_.end());
+}
+
+void Simulator::toggle_play() {
+    {
+        lock_guard<mutex> lock(pending_mutex_);
+        auto now = chrono::steady_clock::now();
+        time_ = playback_time(now);
+        wall_ = now;
+        // playing from the end starts over
+        if (!playing_ && (time_ >= traj_.end() || time_ <= traj_.begin()))
+            time_ = rate_ >= 0 ? traj_.begin() : traj_.end();
+        playing_ = !playing_ && !traj_.empty();
+        dirty_ = true;
+    }
+    wake_.notify_one();
+}
+
+void Simulator::set_rate(double rate) {
+    lock_guard<mutex> lock(pending_mutex_);
+    auto now = chrono::steady_clock::now();
+    time_ = playback_time(now);
+    wall_ = now;
+    rate_ = rate;
+}
+
+double Simulator::rate() const {
+    lock_guard<mutex> lock(pending_mutex_);
+    return rate_;
+}
+
+void Simulator::seek(double t) {
+    {
+        lock_guard<mutex> lock(pending_mutex_);
+        time_ = clamp(t, traj_.begin(), traj_.end());
+        wall_ = chrono::steady_clock::now();
+        dirty_ = true;
+    }
+    wake_.notify_one();
+}
+
+double Simulator::time() const {
+    lock_guard<mutex> lock(pending_mutex_);
+    return traj_.empty() ? NAN : playback_time(chrono::steady_clock::now());
+}
+
+void Simulator::loop() {
+    while (running_) {
+        auto start = chrono::steady_clock::now();
+        Frame &frame = frames_.write_buffer();
+        step(frame);
+        frames_.publish();
+        if (on_publish_)
+            on_publish_();
+
+        {
+            unique_lock<mutex> lock(pending_mutex_);
+            wake_.wait(lock, [this] { return !running_ || dirty_ || playing_; });
+            dirty_ = false;
+        }
+        this_thread::sleep_until(start + SIM_PERIOD);
+    }
+}
+
+void Simulator::step(Frame &frame) {
+    AllocScope alloc_scope("geometry build");
+    frame.clear();
+    frame.seq = ++seq_;
+    for (auto &arena : arenas_)
+        arena.reset();
+
+    apply_pending();
+    frame.coverage.sync(coverage_);
+    frame.objects = objs_;
+    frame.time = step_time_;
+
+    draw_grid_xz(frame, 10.f, 1.f);
+    // draw_plane_xz(frame, 10.f);
+
+    for (const auto &obj : objs_)
+        draw_object(frame, obj, glm::vec3(1, 0, 1), object_pick(obj.id));
+
+    scheduler_.parallel_for(0, cams_.size(), grain_, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            step_camera(i);
+    });
+    frame.cameras = cam_params_;
+
+    for (const auto &cam_frame : cam_frames_) {
+        frame.point.insert(frame.point.end(), cam_frame.point.begin(), cam_frame.point.end());
+        frame.point_id.insert(frame.point_id.end(), cam_frame.point_id.begin(),
+                              cam_frame.point_id.end());
+        frame.line.insert(frame.line.end(), cam_frame.line.begin(), cam_frame.line.end());
+        frame.plane.insert(frame.plane.end(), cam_frame.plane.begin(), cam_frame.plane.end());
+    }
+
+    frame.visible_start.push_back(0);
+    for (const auto &ids : cam_visible_) {
+        frame.visible_id.insert(frame.visible_id.end(), ids.begin(), ids.end());
+        frame.visible_start.push_back((uint32_t)frame.visible_id.size());
+    }
+}
+
+void Simulator::step_camera(size_t i) {
+    const Camera &cam = cams_[i];
+    // visibility only changes with the camera or the objects, static scenes project once
+    if (cam_visible_revision_[i] != cam.get_revision() ||
+        cam_visible_objects_[i] != objs_revision_) {
+        cam_visible_revision_[i] = cam.get_revision();
+        cam_visible_objects_[i] = objs_revision_;
+
+        // the projections are scratch, only the ids of the visible objects are kept
+        FrameArena &arena = arenas_[scheduler_.this_worker()];
+        FrameArena::Scope scope(arena);
+        Span<ProjectedPoint> projected = arena.alloc<ProjectedPoint>(objs_.size());
+        AllocScope alloc_scope("projection");
+        projection::run(objs_, cam.get_mvp(), cam.width_, cam.height_, projected);
+        occlude(occluders_, cam.get_pose(), objs_, projected);
+
+        vector<int> &visible = cam_visible_[i];
+        visible.clear();
+        for (const auto &p : projected)
+            if (p.visible)
+                visible.push_back(p.id);
+    }
+
+    // camera geometry, kept as long as the camera did not change
+    if (cam_revision_[i] == cam.get_revision())
+        return;
+    cam_revision_[i] = cam.get_revision();
+    cam_params_[i] = cam.get_params();
+
+    Frame &out = cam_frames_[i];
+    out.clear();
+    draw_camera(out, cam, glm::vec3(1, 0.647059, 0), PICK_CAMERA | (GLuint)i);
+    draw_footprint(out, cam.get_footprint(), glm::vec3(0, 1.f, 0), cam.get_ground());
+
+    float px_x = 1532.f;
+    float px_y = cam.height_ - 1055.f;
+    glm::vec3 px[INTROJECTION_SAMPLES], pose[INTROJECTION_SAMPLES];
+    for (int k = 0; k < INTROJECTION_SAMPLES; k++)
+        px[k] = glm::vec3(px_x, k / (float)INTROJECTION_SAMPLES, px_y);
+    projection::introjection(Span<const glm::vec3>(px), cam.get_mvp(), cam.width_, cam.height_,
+                             Span<glm::vec3>(pose));
+    for (const auto &p : pose)
+        push_point(out, p, glm::vec3(1, 0.647059, 0));
+}
@@ -0,0 +1,131 @@
+#ifndef __SIMULATOR_HPP__
+#define __SIMULATOR_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "bvh.hpp"
+#include "camera.hpp"
+#include "coverage.hpp"
+#include "footprint.hpp"
+#include "frame.hpp"
+#include "projection.hpp"
+#include "scheduler.hpp"
+#include "trajectory.hpp"
+#include "triple_buffer.hpp"
+
+constexpr std::chrono::milliseconds SIM_PERIOD(16);
+constexpr size_t CAMERA_GRAIN = 4;
+constexpr int INTROJECTION_SAMPLES = 10;
+// ground coverage grid, same extent as the drawn XZ grid
+constexpr float COVERAGE_SIZE = 10.f;
+constexpr float COVERAGE_STEP = 0.25f;
+
+// Owns the camera / object state and runs projection and geometry generation on its own
+// thread. Each step is published as an immutable Frame, so the render thread only ever swaps
+// in the newest snapshot and draws it.
+// Per-camera jobs run as tasks of `grain` cameras on a work-stealing Scheduler.
+// Every frame carries the visibility table of all cameras, objects hidden behind the static
+// `occluders` are left out of it.
+// A step only runs when the state changed (at most once per SIM_PERIOD), otherwise the
+// worker sleeps and the last frame stays current.
+// With trajectories the objects are sampled at the playback time every step, and the worker
+// keeps stepping while playback runs.
+class Simulator {
+  public:
+    Simulator(std::vector<Camera> cams, std::vector<Object> objs, Bvh occluders = Bvh(),
+              size_t grain = CAMERA_GRAIN);
+    ~Simulator();
+
+    void start();
+    void stop();
+
+    // called on the worker thread after every published frame, e.g. to wake an idle render
+    // loop. set before start()
+    void set_on_publish(std::function<void()> fn) { on_publish_ = std::move(fn); }
+
+    // render thread side: swap in the newest published frame, returns true if it changed
+    bool acquire() { return frames_.update(); }
+    const Frame &frame() const { return frames_.read(); }
+
+    // replace camera i, applied on the next step. only the coverage tiles under its old and
+    // new footprint are recounted
+    void set_camera(size_t i, const Camera &cam);
+
+    // replace the objects by recorded tracks, set before start(). playback starts paused at
+    // the first sample
+    void set_trajectories(Trajectories traj);
+    bool has_trajectories() const { return !traj_.empty(); }
+    // playback control, callable from any thread. rate is recorded seconds per second
+    void toggle_play();
+    void set_rate(double rate);
+    double rate() const;
+    void seek(double t);
+    // current playback time
+    double time() const;
+
+  private:
+    void loop();
+    void step(Frame &frame);
+    void step_camera(size_t i);
+    void apply_pending();
+    double playback_time(std::chrono::steady_clock::time_point now) const;
+
+  private:
+    std::vector<Camera> cams_;
+    std::vector<Object> objs_;
+    // changes whenever objs_ is resampled
+    uint64_t objs_revision_;
+    Bvh occluders_;
+
+    Scheduler scheduler_;
+    size_t grain_;
+    // per-camera geometry, merged into the published frame in camera order. it only depends
+    // on the camera and is rebuilt when the camera revision it was drawn from changes
+    std::vector<Frame> cam_frames_;
+    std::vector<uint64_t> cam_revision_;
+    // pose and intrinsics published with every frame, refreshed with the geometry
+    std::vector<CameraParams> cam_params_;
+    // ids of the objects each camera sees, merged into the published visibility table. kept
+    // until the camera revision or objs_revision_ they were computed from changes
+    std::vector<std::vector<int>> cam_visible_;
+    std::vector<uint64_t> cam_visible_revision_;
+    std::vector<uint64_t> cam_visible_objects_;
+    // projection scratch while a camera's visibility is recomputed, one arena per scheduler
+    // thread, reset every step
+    std::vector<FrameArena> arenas_;
+
+    CoverageGrid coverage_;
+
+    // guards pending_, dirty_ and the playback clock
+    mutable std::mutex pending_mutex_;
+    std::condition_variable wake_;
+    std::vector<std::pair<size_t, Camera>> pending_;
+    bool dirty_;
+    std::function<void()> on_publish_;
+
+    // playback clock, guarded by pending_mutex_: playback time is time_ + rate_ * (now - wall_)
+    // while playing
+    Trajectories traj_;
+    bool playing_;
+    double rate_;
+    double time_;
+    std::chrono::steady_clock::time_point wall_;
+    // playback time of the step being built, worker thread only
+    double step_time_;
+
+    TripleBuffer<Frame> frames_;
+    uint64_t seq_;
+
+    std::thread worker_;
+    std::atomic<bool> running_;
+};
+
+#endif
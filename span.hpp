@@ -0,0 +1,45 @@
+#ifndef __SPAN_HPP__
+#define __SPAN_HPP__
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Minimal non-owning view over contiguous memory (std::span is C++20).
+// Lets the core math read from and write into caller-owned buffers without allocating.
+template <typename T> class Span {
+  public:
+    Span() : data_(nullptr), size_(0){};
+    Span(T *data, size_t size) : data_(data), size_(size){};
+
+    template <size_t N> Span(T (&arr)[N]) : data_(arr), size_(N){};
+
+    // any container with data()/size(), e.g. std::vector or std::array
+    template <typename C, typename = typename std::enable_if<std::is_convertible<
+                              decltype(std::declval<C &>().data()), T *>::value>::type>
+    Span(C &c) : data_(c.data()), size_(c.size()){};
+
+    T *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T &operator[](size_t i) const {
+        assert(i < size_);
+        return data_[i];
+    }
+
+    T *begin() const { return data_; }
+    T *end() const { return data_ + size_; }
+
+    Span subspan(size_t offset, size_t count) const {
+        assert(offset + count <= size_);
+        return Span(data_ + offset, count);
+    }
+
+  private:
+    T *data_;
+    size_t size_;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef __SYNTHETIC_HPP__
+#define __SYNTHETIC_HPP__
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "camera.hpp"
+#include "mesh.hpp"
+#include "projection.hpp"
+
+// Reproducible synthetic scenes for benchmarks and stress runs.
+// Positions are in the same offset-relative (x, height, northing) layout as read_cam_config.
+namespace synthetic {
+
+constexpr int WIDTH = 1920;
+constexpr int HEIGHT = 1080;
+
+// half size of a square site that keeps density roughly constant as the scene grows
+inline float site_extent(size_t n) { return 10.f + 2.f * std::sqrt((float)n); }
+
+inline std::vector<CameraParams> make_camera_params(size_t n, float extent, uint32_t seed = 1) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> xz(-extent, extent);
+    std::uniform_real_distribution<float> height(3.f, 15.f);
+    std::uniform_real_distribution<float> pitch(-30.f, 0.f);
+    std::uniform_real_distribution<float> roll(-2.f, 2.f);
+    std::uniform_real_distribution<float> yaw(0.f, 360.f);
+    std::uniform_real_distribution<float> fov(40.f, 70.f);
+
+    std::vector<CameraParams> res(n);
+    for (size_t i = 0; i < n; i++) {
+        res[i].id = (int)i + 1;
+        res[i].pos = glm::vec3(xz(rng), height(rng), xz(rng));
+        res[i].pry = glm::vec3(pitch(rng), roll(rng), yaw(rng));
+        res[i].fov = fov(rng);
+        res[i].width = WIDTH;
+        res[i].height = HEIGHT;
+        res[i].near = 1.f;
+        res[i].far = 50.f;
+    }
+    return res;
+}
+
+inline std::vector<Camera> make_cameras(size_t n, float extent, uint32_t seed = 1) {
+    std::vector<CameraParams> params = make_camera_params(n, extent, seed);
+    std::vector<Camera> res;
+    Camera::build(params, res);
+    return res;
+}
+
+inline std::vector<Object> make_objects(size_t n, float extent, uint32_t seed = 2) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> xz(-extent, extent);
+    std::uniform_real_distribution<float> height(0.f, 3.f);
+
+    std::vector<Object> res;
+    res.reserve(n);
+    for (size_t i = 0; i < n; i++)
+        res.push_back(Object((int)i + 1, glm::vec3(xz(rng), height(rng), xz(rng))));
+    return res;
+}
+// n box shaped buildings standing on the ground
+inline Mesh make_buildings(size_t n, float extent, uint32_t seed = 3) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> xz(-extent, extent);
+    std::uniform_real_distribution<float> side(1.f, 4.f);
+    std::uniform_real_distribution<float> height(3.f, 20.f);
+
+    // box corners are indexed by bits (x, y, z), the floor is left open
+    static const int quads[5][4] = {
+        {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 6, 7, 5}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+
+    Mesh res;
+    res.vertex.reserve(8 * n);
+    res.face.reserve(10 * n);
+    for (size_t i = 0; i < n; i++) {
+        glm::vec3 lo(xz(rng), 0.f, xz(rng));
+        glm::vec3 hi = lo + glm::vec3(side(rng), height(rng), side(rng));
+        int base = (int)res.vertex.size();
+        for (int c = 0; c < 8; c++)
+            res.vertex.push_back(glm::vec3(c & 1 ? hi.x : lo.x, c & 2 ? hi.y : lo.y,
+                                           c & 4 ? hi.z : lo.z));
+        for (const auto &q : quads) {
+            res.face.push_back(glm::ivec3(base + q[0], base + q[1], base + q[2]));
+            res.face.push_back(glm::ivec3(base + q[0], base + q[2], base + q[3]));
+        }
+    }
+    return res;
+}
+} // namespace synthetic
+
+#endif
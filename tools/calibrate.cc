@@ -0,0 +1,176 @@
+// Refines the pose and fov of every camera in a cam.json from pixel <-> world correspondences.
+//
+// usage: frustumcam-calibrate <cam.json> [correspondences | -] [-o <out.json>]
+//                             [--fix-position] [--fix-orientation] [--fix-fov]
+//                             [--iterations <n>] [--threads <n>]
+//
+// Every input row is `cam-id, px, py, easting, northing, height`, the output format of
+// frustumcam-geolocate (pixel origin top-left, UTM as in cam.json). With a geodetic cam.json
+// (llh positions) the world columns are `latitude, longitude, height`.
+// Rows that do not parse, hold nan or belong to unknown cameras are skipped. The refined
+// cameras are written as cam.json (stdout by default), the rms reprojection error before and
+// after goes to stderr. Cameras without enough correspondences, or with one behind them, are
+// written as is.
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "calibration.hpp"
+#include "camera.hpp"
+#include "config.hpp"
+#include "scheduler.hpp"
+
+using namespace std;
+
+namespace {
+
+// `cam-id, px, py, x, y, z` separated by commas, semicolons or whitespace
+bool parse(const string &line, int &cam_id, double (&v)[5]) {
+    const char *p = line.c_str();
+    char *next;
+    for (int f = 0; f < 6; f++) {
+        while (*p == ',' || *p == ' ' || *p == '\t' || *p == ';')
+            p++;
+        if (f == 0) {
+            long id = strtol(p, &next, 10);
+            cam_id = (int)id;
+        } else {
+            v[f - 1] = strtod(p, &next);
+            // geolocate writes nan for rays that miss the ground
+            if (!isfinite(v[f - 1]))
+                return false;
+        }
+        if (next == p)
+            return false;
+        p = next;
+    }
+    return true;
+}
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog
+         << " <cam.json> [correspondences | -] [-o <out.json>] [--fix-position]"
+            " [--fix-orientation] [--fix-fov] [--iterations <n>] [--threads <n>]"
+         << endl;
+    exit(EXIT_FAILURE);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    string cam_file, input = "-", out_file = "-";
+    calibration::Options opt;
+    size_t threads = Scheduler::default_workers();
+
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            out_file = argv[++i];
+        } else if (arg == "--fix-position") {
+            opt.position = false;
+        } else if (arg == "--fix-orientation") {
+            opt.orientation = false;
+        } else if (arg == "--fix-fov") {
+            opt.fov = false;
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            opt.max_iterations = atoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            size_t n = strtoul(argv[++i], nullptr, 10);
+            threads = n > 1 ? n - 1 : 0;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            usage(argv[0]);
+        } else if (positional == 0) {
+            cam_file = arg;
+            positional++;
+        } else if (positional == 1) {
+            input = arg;
+            positional++;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (cam_file.empty())
+        usage(argv[0]);
+
+    glm::dvec3 offset;
+    GeoFrame geo;
+    vector<Camera> cams = read_cam_config(cam_file, offset, &geo);
+    if (cams.empty()) {
+        cerr << "no camera object!" << endl;
+        exit(EXIT_FAILURE);
+    }
+    unordered_map<int, int> index;
+    for (size_t i = 0; i < cams.size(); i++)
+        index[cams[i].get_id()] = (int)i;
+
+    ifstream file_handler;
+    if (input != "-") {
+        file_handler.open(input);
+        if (!file_handler.is_open()) {
+            cerr << "reading correspondences fail!" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    istream &in = input == "-" ? cin : file_handler;
+
+    // world positions are gathered first so geodetic rows are converted in one batch
+    vector<int> cam_idx;
+    vector<glm::vec2> px;
+    vector<glm::dvec3> pos;
+    size_t skipped = 0;
+    string line;
+    while (getline(in, line)) {
+        int cam_id;
+        double v[5];
+        auto it = parse(line, cam_id, v) ? index.find(cam_id) : index.end();
+        if (it == index.end()) {
+            skipped++;
+            continue;
+        }
+        const Camera &cam = cams[it->second];
+        cam_idx.push_back(it->second);
+        px.push_back(glm::vec2(v[0], cam.height_ - v[1]));
+        pos.push_back(glm::dvec3(v[2], v[3], v[4]));
+    }
+    if (geo.geodetic)
+        geo.enu.llh_to_enu(pos, pos);
+
+    Correspondences corr;
+    for (size_t i = 0; i < pos.size(); i++)
+        corr.push(cam_idx[i], utm_to_world(pos[i], offset), px[i]);
+
+    Scheduler scheduler(threads);
+    vector<calibration::Result> res = calibration::run(cams, corr, opt, scheduler);
+
+    size_t refined = 0;
+    double before = 0, after = 0;
+    for (size_t i = 0; i < cams.size(); i++) {
+        const calibration::Result &r = res[i];
+        if (!r.valid) {
+            if (r.points > 0)
+                cerr << "cam " << cams[i].get_id() << ": not refined (" << r.points
+                     << " points)" << endl;
+            continue;
+        }
+        refined++;
+        before += r.rms_before;
+        after += r.rms_after;
+    }
+    if (skipped)
+        cerr << "skipped " << skipped << " rows" << endl;
+    if (refined)
+        cerr << "refined " << refined << " of " << cams.size()
+             << " cameras, mean rms error " << before / refined << " -> " << after / refined
+             << " px" << endl;
+
+    write_cam_config(out_file, cams, offset, &geo);
+    return EXIT_SUCCESS;
+}
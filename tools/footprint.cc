@@ -0,0 +1,52 @@
+// Ground footprint polygons of every camera in a cam.json.
+//
+// usage: frustumcam-footprint <cam.json> --ground <height> [-o <out.json>]
+//
+// Intersects each frustum, clipped by its near and far planes, with the horizontal plane at
+// <height> (UTM height, or ellipsoidal height for a cam.json in llh) and writes the convex
+// polygons as json, see write_footprints().
+// Cameras that do not see the ground get an empty polygon.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "camera.hpp"
+#include "config.hpp"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+    string cam_file, out_file = "-";
+    bool has_ground = false;
+    double ground_height = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--ground" && i + 1 < argc) {
+            has_ground = true;
+            ground_height = atof(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            out_file = argv[++i];
+        } else if (cam_file.empty() && arg[0] != '-') {
+            cam_file = arg;
+        } else {
+            has_ground = false;
+            break;
+        }
+    }
+    if (cam_file.empty() || !has_ground) {
+        cerr << "usage: " << argv[0] << " <cam.json> --ground <height> [-o <out.json>]" << endl;
+        return EXIT_FAILURE;
+    }
+
+    glm::dvec3 offset;
+    GeoFrame geo;
+    vector<Camera> cams = read_cam_config(cam_file, offset, &geo);
+    for (auto &cam : cams)
+        cam.set_ground((float)(ground_height - offset.y));
+
+    write_footprints(out_file, cams, offset, &geo);
+    return EXIT_SUCCESS;
+}
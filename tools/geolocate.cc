@@ -0,0 +1,275 @@
+// Batch geolocation of pixel detections without a window.
+//
+// usage: frustumcam-geolocate <cam.json> [detections | -] --ground <height> [--threads <n>]
+//                             [--block <MiB>]
+//
+// Every input row is `cam-id, px, py` (comma or whitespace separated, pixel origin top-left).
+// The ray through the pixel is intersected with the horizontal ground plane at <height> (UTM
+// height, same unit as cam.json) and written to stdout as
+// `cam-id,px,py,easting,northing,height` in the UTM frame of cam.json, in input order. With a
+// geodetic cam.json (llh positions) the ray starts at the camera's own origin and meets the
+// surface at ellipsoidal height <height>, the output is `cam-id,px,py,latitude,longitude,height`.
+// Rows that do not parse (headers, comments) are skipped, rows whose ray misses the ground
+// are written with nan coordinates.
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "camera.hpp"
+#include "config.hpp"
+#include "geodesy.hpp"
+#include "projection.hpp"
+#include "scheduler.hpp"
+
+using namespace std;
+
+namespace {
+
+struct CameraInfo {
+    glm::mat4 inv_mvp;
+    int width;
+    int height;
+    // geodetic configs only: ecef position, and the inverse mvp of the camera moved to the
+    // scene origin, so rays far from the first camera do not lose their direction to floats
+    glm::dvec3 origin;
+    glm::mat4 inv_dir;
+};
+
+struct Chunk {
+    const char *begin;
+    const char *end;
+    string out;
+    size_t skipped;
+};
+
+struct Geolocator {
+    unordered_map<int, CameraInfo> cams;
+    glm::dvec3 offset;
+    GeoFrame frame;
+    float ground;
+    // ellipsoidal height of the ground, geodetic configs only
+    double height;
+
+    // parse and geolocate every line in [begin, end), which ends on a newline
+    void run(Chunk &chunk) const {
+        chunk.out.clear();
+        chunk.skipped = 0;
+
+        char buf[160];
+        const char *line = chunk.begin;
+        while (line < chunk.end) {
+            const char *eol = static_cast<const char *>(memchr(line, '\n', chunk.end - line));
+            if (!eol)
+                eol = chunk.end;
+
+            int cam_id;
+            float px, py;
+            if (!parse(line, eol, cam_id, px, py)) {
+                chunk.skipped += skip_blank(line, eol) ? 0 : 1;
+                line = eol + 1;
+                continue;
+            }
+
+            glm::dvec3 pos(NAN, NAN, NAN);
+            auto it = cams.find(cam_id);
+            if (it != cams.end()) {
+                const CameraInfo &cam = it->second;
+                glm::vec2 pixel(px, cam.height - py);
+                glm::vec3 world;
+                if (frame.geodetic)
+                    pos = geolocate(cam, pixel);
+                else if (projection::ground_intersection(pixel, cam.inv_mvp, cam.width,
+                                                         cam.height, ground, world))
+                    pos = world_to_utm(world, offset);
+            }
+
+            const char *format =
+                frame.geodetic ? "%d,%g,%g,%.9f,%.9f,%.3f\n" : "%d,%g,%g,%.3f,%.3f,%.3f\n";
+            int len = snprintf(buf, sizeof(buf), format, cam_id, px, py, pos.x, pos.y, pos.z);
+            chunk.out.append(buf, len);
+            line = eol + 1;
+        }
+    }
+
+    // llh where the pixel's ray meets the ground height, nan when it does not
+    glm::dvec3 geolocate(const CameraInfo &cam, const glm::vec2 &px) const {
+        glm::vec3 d =
+            projection::unproject(glm::vec3(px.x, 1.f, px.y), cam.inv_dir, cam.width, cam.height);
+        glm::dvec3 dir = glm::transpose(frame.enu.rotation()) * glm::dvec3(d.x, -d.z, d.y);
+        glm::dvec3 hit;
+        if (!geodesy::intersect_height(cam.origin, dir, height, hit))
+            return glm::dvec3(NAN, NAN, NAN);
+        return geodesy::ecef_to_llh(hit);
+    }
+
+    static bool skip_blank(const char *p, const char *eol) {
+        for (; p < eol; p++)
+            if (!isspace((unsigned char)*p))
+                return false;
+        return true;
+    }
+
+    static const char *next_field(const char *p, const char *eol) {
+        while (p < eol && (*p == ',' || *p == ' ' || *p == '\t' || *p == ';'))
+            p++;
+        return p;
+    }
+
+    static bool parse(const char *p, const char *eol, int &cam_id, float &px, float &py) {
+        char *next;
+        p = next_field(p, eol);
+        long id = strtol(p, &next, 10);
+        if (next == p || next > eol)
+            return false;
+
+        p = next_field(next, eol);
+        px = strtof(p, &next);
+        if (next == p || next > eol)
+            return false;
+
+        p = next_field(next, eol);
+        py = strtof(p, &next);
+        if (next == p || next > eol)
+            return false;
+
+        cam_id = (int)id;
+        return true;
+    }
+};
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog
+         << " <cam.json> [detections | -] --ground <height> [--threads <n>] [--block <MiB>]"
+         << endl;
+    exit(EXIT_FAILURE);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    string cam_file, input = "-";
+    bool has_ground = false;
+    double ground_height = 0;
+    size_t threads = Scheduler::default_workers();
+    size_t block_size = 16 << 20;
+
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--ground" && i + 1 < argc) {
+            has_ground = true;
+            ground_height = atof(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            size_t n = strtoul(argv[++i], nullptr, 10);
+            threads = n > 1 ? n - 1 : 0;
+        } else if (arg == "--block" && i + 1 < argc) {
+            block_size = max<size_t>(1, strtoul(argv[++i], nullptr, 10)) << 20;
+        } else if (arg.size() > 1 && arg[0] == '-' && arg[1] == '-') {
+            usage(argv[0]);
+        } else if (positional == 0) {
+            cam_file = arg;
+            positional++;
+        } else if (positional == 1) {
+            input = arg;
+            positional++;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (cam_file.empty() || !has_ground)
+        usage(argv[0]);
+
+    Geolocator geo;
+    vector<Camera> cams = read_cam_config(cam_file, geo.offset, &geo.frame);
+    if (cams.empty()) {
+        cerr << "no camera object!" << endl;
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < cams.size(); i++) {
+        const Camera &cam = cams[i];
+        CameraInfo info{glm::inverse(cam.get_mvp()), cam.width_, cam.height_, glm::dvec3(0),
+                        glm::mat4(1.f)};
+        if (geo.frame.geodetic) {
+            info.origin = geo.frame.local[i].origin_ecef();
+            glm::mat4 proj = glm::perspective(glm::radians(cam.get_fov()),
+                                              cam.width_ / (float)cam.height_, cam.near_, cam.far_);
+            info.inv_dir = glm::inverse(proj * glm::mat4(glm::mat3_cast(cam.get_orientation())));
+        }
+        geo.cams[cam.get_id()] = info;
+    }
+    geo.ground = (float)(ground_height - geo.offset.y);
+    geo.height = ground_height;
+
+    FILE *in = input == "-" ? stdin : fopen(input.c_str(), "rb");
+    if (!in) {
+        cerr << "reading detections fail!" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    Scheduler scheduler(threads);
+    size_t n_chunks = scheduler.size() * 4;
+    vector<Chunk> chunks(n_chunks);
+
+    // read a block, cut it into line-aligned chunks, geolocate them in parallel and write the
+    // results back in chunk order
+    string block;
+    size_t carry = 0, skipped = 0;
+    bool eof = false;
+    while (!eof) {
+        block.resize(carry + block_size);
+        size_t got = fread(&block[carry], 1, block_size, in);
+        eof = got < block_size;
+        size_t filled = carry + got;
+
+        size_t usable = filled;
+        if (!eof) {
+            while (usable > 0 && block[usable - 1] != '\n')
+                usable--;
+        } else if (filled > 0 && block[filled - 1] != '\n') {
+            // terminate the last row so parsing never runs into stale buffer contents
+            block[filled++] = '\n';
+            usable = filled;
+        }
+
+        const char *base = block.data();
+        size_t begin = 0;
+        for (size_t c = 0; c < n_chunks; c++) {
+            size_t end = c + 1 == n_chunks ? usable : max(begin, usable * (c + 1) / n_chunks);
+            const char *nl =
+                end < usable ? static_cast<const char *>(memchr(base + end, '\n', usable - end))
+                             : nullptr;
+            end = nl ? nl - base + 1 : usable;
+            chunks[c].begin = base + begin;
+            chunks[c].end = base + end;
+            begin = end;
+        }
+
+        scheduler.parallel_for(0, n_chunks, 1, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; c++)
+                geo.run(chunks[c]);
+        });
+
+        for (const auto &chunk : chunks) {
+            fwrite(chunk.out.data(), 1, chunk.out.size(), stdout);
+            skipped += chunk.skipped;
+        }
+
+        carry = filled - usable;
+        memmove(&block[0], base + usable, carry);
+    }
+
+    if (in != stdin)
+        fclose(in);
+    fflush(stdout);
+
+    if (skipped)
+        cerr << "skipped " << skipped << " unparsable rows" << endl;
+    return EXIT_SUCCESS;
+}
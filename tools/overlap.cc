@@ -0,0 +1,65 @@
+// Pairwise frustum overlap of every camera in a cam.json.
+//
+// usage: frustumcam-overlap <cam.json> [--threads <n>] [--grain <pairs>]
+//
+// Writes one `cam-id-a,cam-id-b,volume,fraction` row per overlapping pair to stdout, where
+// fraction is the overlap volume relative to the smaller of the two frusta.
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "camera.hpp"
+#include "config.hpp"
+#include "overlap.hpp"
+#include "scheduler.hpp"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+    string cam_file;
+    size_t threads = Scheduler::default_workers();
+    size_t grain = 64;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            size_t n = strtoul(argv[++i], nullptr, 10);
+            threads = n > 1 ? n - 1 : 0;
+        } else if (arg == "--grain" && i + 1 < argc) {
+            grain = strtoul(argv[++i], nullptr, 10);
+        } else if (cam_file.empty() && arg[0] != '-') {
+            cam_file = arg;
+        } else {
+            cerr << "usage: " << argv[0] << " <cam.json> [--threads <n>] [--grain <pairs>]"
+                 << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (cam_file.empty()) {
+        cerr << "usage: " << argv[0] << " <cam.json> [--threads <n>] [--grain <pairs>]" << endl;
+        return EXIT_FAILURE;
+    }
+
+    glm::dvec3 offset;
+    vector<Camera> cams = read_cam_config(cam_file, offset);
+
+    Scheduler scheduler(threads);
+    OverlapMatrix mat = overlap::run(cams, scheduler, grain);
+
+    vector<float> volumes(cams.size());
+    for (size_t i = 0; i < cams.size(); i++)
+        volumes[i] = overlap::volume(cams[i].get_frustum());
+
+    for (size_t i = 0; i < cams.size(); i++) {
+        for (size_t k = mat.row[i]; k < mat.row[i + 1]; k++) {
+            int j = mat.col[k];
+            float smaller = min(volumes[i], volumes[j]);
+            printf("%d,%d,%.3f,%.4f\n", cams[i].get_id(), cams[j].get_id(), mat.volume[k],
+                   smaller > 0 ? mat.volume[k] / smaller : 0.f);
+        }
+    }
+    return EXIT_SUCCESS;
+}
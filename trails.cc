@@ -0,0 +1,114 @@
+#include "trails.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "alloc_track.hpp"
+
+using namespace std;
+
+Trails::Trails(int length)
+    : shader_("../shaders/draw_trail.glsl"), length_(max(length, 2)), head_(0), filled_(0),
+      capacity_(0), time_(NAN) {
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &tbo_);
+    glGenTextures(1, &tex_);
+    grow(1024);
+}
+
+Trails::~Trails() {
+    glDeleteTextures(1, &tex_);
+    glDeleteBuffers(1, &tbo_);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void Trails::grow(size_t slots) {
+    size_t capacity = max(slots, capacity_ * 2);
+    size_t layer_bytes = capacity * sizeof(glm::vec4);
+
+    GLuint tbo;
+    glGenBuffers(1, &tbo);
+    glBindBuffer(GL_TEXTURE_BUFFER, tbo);
+    vector<glm::vec4> zero(capacity * length_, glm::vec4(0));
+    glBufferData(GL_TEXTURE_BUFFER, layer_bytes * length_, zero.data(), GL_DYNAMIC_DRAW);
+
+    // the layer stride changes, move the history over layer by layer
+    if (capacity_ > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, tbo_);
+        for (int l = 0; l < length_; l++)
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_TEXTURE_BUFFER,
+                                l * capacity_ * sizeof(glm::vec4), l * layer_bytes,
+                                capacity_ * sizeof(glm::vec4));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glDeleteBuffers(1, &tbo_);
+    tbo_ = tbo;
+    capacity_ = capacity;
+
+    glBindTexture(GL_TEXTURE_BUFFER, tex_);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, tbo_);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void Trails::clear() {
+    filled_ = 0;
+    head_ = 0;
+}
+
+void Trails::push(const Frame &frame) {
+    AllocScope alloc_scope("upload");
+    // camera edits republish the same time while paused
+    if (std::isnan(frame.time) || frame.time == time_)
+        return;
+    // going back in time would connect unrelated positions
+    if (frame.time < time_)
+        clear();
+    time_ = frame.time;
+
+    for (const auto &obj : frame.objects)
+        slot_of_.try_emplace(obj.id, (uint32_t)slot_of_.size());
+    if (slot_of_.size() > capacity_)
+        grow(slot_of_.size());
+
+    layer_.assign(slot_of_.size(), glm::vec4(0));
+    for (const auto &obj : frame.objects)
+        layer_[slot_of_[obj.id]] = glm::vec4(obj.pt, 1.f);
+
+    head_ = (head_ + 1) % length_;
+    filled_ = min(filled_ + 1, length_);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, tbo_);
+    glBufferSubData(GL_TEXTURE_BUFFER, head_ * capacity_ * sizeof(glm::vec4),
+                    layer_.size() * sizeof(glm::vec4), layer_.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void Trails::draw(const glm::mat4 &mvp, const glm::vec3 &color) {
+    if (filled_ < 2 || slot_of_.empty())
+        return;
+
+    shader_.use();
+    shader_.set_mat4("mvp", mvp);
+    shader_.set_vec3("color", color);
+    shader_.set_int("history", 0);
+    shader_.set_int("head", head_);
+    shader_.set_int("ring_length", length_);
+    shader_.set_int("filled", filled_);
+    shader_.set_int("stride", (int)capacity_);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, tex_);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    // (length - 1) segments per object, 2 vertices each
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_LINES, 0, (GLsizei)(slot_of_.size() * (length_ - 1) * 2));
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
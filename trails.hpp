@@ -0,0 +1,56 @@
+#ifndef __TRAILS_HPP__
+#define __TRAILS_HPP__
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "frame.hpp"
+#include "shader.hpp"
+
+constexpr int TRAIL_LENGTH = 64;
+
+// Fading position history of every object, kept on the GPU.
+// The history is a ring of `length` layers in a texture buffer, one vec4 per object slot
+// (w = 0 where the object was absent). Each published frame uploads a single layer with
+// the newest positions. The trail polylines are generated in the vertex shader from
+// gl_VertexID, so the CPU never builds trail geometry. Texture buffers and gl_VertexID are
+// GLSL 3.30, so the trail shader runs on the 3.3 core context the viewer asks for.
+class Trails {
+  public:
+    explicit Trails(int length = TRAIL_LENGTH);
+    ~Trails();
+
+    // append the objects of a frame at a new playback time, frames without a time or at the
+    // time already appended are ignored
+    void push(const Frame &frame);
+    // forget the history, e.g. after a seek
+    void clear();
+    void draw(const glm::mat4 &mvp, const glm::vec3 &color);
+
+  private:
+    void grow(size_t slots);
+
+  private:
+    Shader shader_;
+    GLuint vao_;
+    GLuint tbo_;
+    GLuint tex_;
+
+    int length_;
+    // layer with the newest samples and the number of layers written since clear()
+    int head_;
+    int filled_;
+
+    // slots per layer allocated / in use, objects keep their slot for the whole run
+    size_t capacity_;
+    std::unordered_map<int, uint32_t> slot_of_;
+    std::vector<glm::vec4> layer_;
+
+    double time_;
+};
+
+#endif
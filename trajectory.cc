@@ -0,0 +1,141 @@
+#include "trajectory.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+#include "config.hpp"
+
+using namespace std;
+
+namespace {
+constexpr size_t MAX_BUCKETS = 1 << 16;
+} // namespace
+
+Trajectories::Trajectories(const vector<int> &ids, const vector<double> &times,
+                           const vector<glm::vec3> &pos) {
+    size_t n = ids.size();
+    if (n == 0)
+        return;
+
+    vector<uint32_t> order(n);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return ids[a] < ids[b] || (ids[a] == ids[b] && times[a] < times[b]);
+    });
+
+    times_.resize(n);
+    pos_.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        uint32_t i = order[k];
+        if (k == 0 || ids[i] != ids[order[k - 1]]) {
+            track_id_.push_back(ids[i]);
+            track_first_.push_back((uint32_t)k);
+        }
+        times_[k] = times[i];
+        pos_[k] = pos[i];
+    }
+    track_first_.push_back((uint32_t)n);
+
+    begin_ = *min_element(times_.begin(), times_.end());
+    end_ = *max_element(times_.begin(), times_.end());
+
+    // about one bucket per sample of an average track, which keeps the index no larger than
+    // the samples themselves
+    size_t buckets = min(MAX_BUCKETS, max<size_t>(1, n / tracks()));
+    bucket_width_ = end_ > begin_ ? (end_ - begin_) / buckets : 1.0;
+
+    auto bucket_of = [&](double t) {
+        return min(buckets - 1, (size_t)max(0.0, (t - begin_) / bucket_width_));
+    };
+
+    vector<uint32_t> count(buckets + 1, 0);
+    for (size_t k = 0; k < tracks(); k++) {
+        size_t b0 = bucket_of(times_[track_first_[k]]);
+        size_t b1 = bucket_of(times_[track_first_[k + 1] - 1]);
+        for (size_t b = b0; b <= b1; b++)
+            count[b + 1]++;
+    }
+    partial_sum(count.begin(), count.end(), count.begin());
+    bucket_first_ = count;
+
+    entries_.resize(bucket_first_.back());
+    for (size_t k = 0; k < tracks(); k++) {
+        uint32_t s = track_first_[k], last = track_first_[k + 1] - 1;
+        size_t b0 = bucket_of(times_[s]);
+        size_t b1 = bucket_of(times_[last]);
+        for (size_t b = b0; b <= b1; b++) {
+            double start = begin_ + b * bucket_width_;
+            while (s < last && times_[s + 1] <= start)
+                s++;
+            entries_[count[b]++] = Entry{(uint32_t)k, s};
+        }
+    }
+}
+
+size_t Trajectories::sample(double t, vector<Object> &out) const {
+    out.clear();
+    if (empty() || t < begin_ || t > end_)
+        return 0;
+
+    size_t buckets = bucket_first_.size() - 1;
+    size_t b = min(buckets - 1, (size_t)max(0.0, (t - begin_) / bucket_width_));
+    for (uint32_t e = bucket_first_[b]; e < bucket_first_[b + 1]; e++) {
+        const Entry &entry = entries_[e];
+        uint32_t first = track_first_[entry.track], last = track_first_[entry.track + 1] - 1;
+        if (t < times_[first] || t > times_[last])
+            continue;
+
+        // first sample after t, the one before it starts the interpolated segment
+        const double *hi = upper_bound(&times_[entry.sample], &times_[last] + 1, t);
+        size_t i = hi - times_.data();
+
+        Object obj;
+        obj.id = track_id_[entry.track];
+        if (i > last) {
+            obj.pt = pos_[last];
+        } else {
+            size_t j = i - 1;
+            double w = (t - times_[j]) / (times_[i] - times_[j]);
+            obj.pt = glm::mix(pos_[j], pos_[i], (float)w);
+        }
+        out.push_back(obj);
+    }
+    return out.size();
+}
+
+Trajectories read_trajectory(const std::string &file, const glm::dvec3 &offset) {
+    ifstream file_handler(file);
+    if (!file_handler.is_open()) {
+        cerr << "reading trajectory fail!" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    vector<int> ids;
+    vector<double> times;
+    vector<glm::vec3> pos;
+    string line;
+    size_t skipped = 0;
+    while (getline(file_handler, line)) {
+        for (char &c : line)
+            if (c == ',' || c == ';' || c == '\t')
+                c = ' ';
+        int id;
+        double t;
+        glm::dvec3 utm;
+        if (sscanf(line.c_str(), "%d %lf %lf %lf %lf", &id, &t, &utm.x, &utm.y, &utm.z) != 5) {
+            skipped += line.find_first_not_of(" \r") != string::npos;
+            continue;
+        }
+        ids.push_back(id);
+        times.push_back(t);
+        pos.push_back(utm_to_world(utm, offset));
+    }
+
+    if (skipped)
+        cerr << "trajectory: skipped " << skipped << " unparsable rows" << endl;
+    return Trajectories(ids, times, pos);
+}
@@ -0,0 +1,58 @@
+#ifndef __TRAJECTORY_HPP__
+#define __TRAJECTORY_HPP__
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "projection.hpp"
+
+// Recorded object tracks, sampled at any instant by linear interpolation.
+// Samples are grouped per object and sorted by time. A bucket index over the recorded time
+// range lists the tracks alive in each bucket together with their first sample in it, so a
+// seek touches one bucket and does a binary search inside each live track.
+class Trajectories {
+  public:
+    Trajectories(){};
+    // one sample per entry, in any order. positions are scene world coordinates
+    Trajectories(const std::vector<int> &ids, const std::vector<double> &times,
+                 const std::vector<glm::vec3> &pos);
+
+    bool empty() const { return times_.empty(); }
+    size_t tracks() const { return track_id_.size(); }
+    int track_id(size_t track) const { return track_id_[track]; }
+    size_t samples() const { return times_.size(); }
+    double begin() const { return begin_; }
+    double end() const { return end_; }
+
+    // position of every object whose track covers `t`, ordered by object id.
+    // out is overwritten, returns the number of objects
+    size_t sample(double t, std::vector<Object> &out) const;
+
+  private:
+    struct Entry {
+        uint32_t track;
+        uint32_t sample; // first sample of the track at or after the bucket start
+    };
+
+    std::vector<int> track_id_;
+    std::vector<uint32_t> track_first_; // tracks() + 1 entries
+
+    std::vector<double> times_;
+    std::vector<glm::vec3> pos_;
+
+    double begin_ = 0;
+    double end_ = 0;
+    double bucket_width_ = 1;
+    std::vector<uint32_t> bucket_first_; // buckets + 1 entries into entries_
+    std::vector<Entry> entries_;
+};
+
+// `obj-id, timestamp, x, y, z` rows (comma or whitespace separated), xyz in UTM (easting,
+// northing, height) like object.json and timestamps in seconds. Rows that do not parse are
+// skipped
+Trajectories read_trajectory(const std::string &file, const glm::dvec3 &offset);
+
+#endif
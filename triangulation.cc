@@ -0,0 +1,103 @@
+#include "triangulation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+#include "projection.hpp"
+
+using namespace std;
+
+namespace triangulation {
+
+namespace {
+
+// reject systems whose rays are closer to parallel than this (determinant of sum(I - d d^T))
+constexpr float MIN_DET = 1e-9f;
+
+void solve(Span<const View> views, const Observations &obs, const uint32_t *idx, int n,
+           Triangulated &out) {
+    out.views = n;
+    out.valid = false;
+    out.error = NAN;
+    out.pos = glm::vec3(NAN);
+    if (n < 2)
+        return;
+
+    // normal equations of sum_i |(I - d_i d_i^T)(x - o_i)|^2
+    glm::mat3 a(0.f);
+    glm::vec3 b(0.f);
+    for (int k = 0; k < n; k++) {
+        uint32_t i = idx[k];
+        const View &v = views[obs.camera[i]];
+        const glm::vec2 &px = obs.px[i];
+        // ray from the near to the far plane through the pixel
+        glm::vec3 o = projection::unproject(glm::vec3(px.x, 0.f, px.y), v.inv_mvp, v.width,
+                                            v.height);
+        glm::vec3 e = projection::unproject(glm::vec3(px.x, 1.f, px.y), v.inv_mvp, v.width,
+                                            v.height);
+        glm::vec3 d = glm::normalize(e - o);
+        glm::mat3 p = glm::mat3(1.f) - glm::outerProduct(d, d);
+        a += p;
+        b += p * o;
+    }
+    if (fabs(glm::determinant(a)) < MIN_DET)
+        return;
+    out.pos = glm::inverse(a) * b;
+
+    float sq = 0.f;
+    for (int k = 0; k < n; k++) {
+        uint32_t i = idx[k];
+        const View &v = views[obs.camera[i]];
+        glm::vec4 clip = v.mvp * glm::vec4(out.pos, 1.f);
+        if (clip.w <= 0.f)
+            return;
+        glm::vec2 win(v.width * (clip.x / clip.w + 1.f) / 2.f,
+                      v.height * (clip.y / clip.w + 1.f) / 2.f);
+        glm::vec2 diff = win - obs.px[i];
+        sq += glm::dot(diff, diff);
+    }
+    out.error = sqrt(sq / n);
+    out.valid = true;
+}
+} // namespace
+
+vector<View> views(Span<const Camera> cams) {
+    vector<View> res(cams.size());
+    for (size_t i = 0; i < cams.size(); i++) {
+        res[i].mvp = cams[i].get_mvp();
+        res[i].inv_mvp = glm::inverse(res[i].mvp);
+        res[i].width = cams[i].width_;
+        res[i].height = cams[i].height_;
+    }
+    return res;
+}
+
+vector<Triangulated> run(Span<const View> views, const Observations &obs, Scheduler &scheduler,
+                         size_t grain) {
+    assert(obs.camera.size() == obs.size() && obs.px.size() == obs.size());
+
+    // group observations by target
+    vector<uint32_t> order(obs.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(),
+                [&](uint32_t a, uint32_t b) { return obs.object[a] < obs.object[b]; });
+
+    vector<uint32_t> first;
+    for (size_t k = 0; k < order.size(); k++)
+        if (k == 0 || obs.object[order[k]] != obs.object[order[k - 1]])
+            first.push_back((uint32_t)k);
+    first.push_back((uint32_t)order.size());
+
+    vector<Triangulated> res(first.size() - 1);
+    scheduler.parallel_for(0, res.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            res[t].id = obs.object[order[first[t]]];
+            solve(views, obs, &order[first[t]], (int)(first[t + 1] - first[t]), res[t]);
+        }
+    });
+    return res;
+}
+} // namespace triangulation
@@ -0,0 +1,65 @@
+#ifndef __TRIANGULATION_HPP__
+#define __TRIANGULATION_HPP__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "camera.hpp"
+#include "scheduler.hpp"
+#include "span.hpp"
+
+// Detections of the same targets in several cameras, one entry per (object, camera, pixel)
+// in structure-of-arrays form and in any order.
+// camera is an index into the camera list, px follows introjection(): (column, row from the
+// bottom of the image).
+struct Observations {
+    std::vector<int> object;
+    std::vector<int> camera;
+    std::vector<glm::vec2> px;
+
+    size_t size() const { return object.size(); }
+    void clear() {
+        object.clear();
+        camera.clear();
+        px.clear();
+    }
+    void push(int object_id, int camera_idx, const glm::vec2 &pixel) {
+        object.push_back(object_id);
+        camera.push_back(camera_idx);
+        px.push_back(pixel);
+    }
+};
+
+struct Triangulated {
+    int id;
+    glm::vec3 pos;
+    int views;
+    // rms reprojection error over all views in pixels
+    float error;
+    // false for targets seen once or only along (nearly) parallel rays, pos is meaningless then
+    bool valid;
+};
+
+namespace triangulation {
+
+// per-camera matrices cached once for every batch
+struct View {
+    glm::mat4 mvp;
+    glm::mat4 inv_mvp;
+    int width;
+    int height;
+};
+
+std::vector<View> views(Span<const Camera> cams);
+
+// midpoint triangulation: the point with the least squared distance to the rays of all
+// observations of a target. targets are solved as tasks of `grain` on the scheduler and
+// returned sorted by id
+std::vector<Triangulated> run(Span<const View> views, const Observations &obs,
+                              Scheduler &scheduler, size_t grain = 256);
+} // namespace triangulation
+
+#endif
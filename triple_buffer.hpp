@@ -0,0 +1,39 @@
+#ifndef __TRIPLE_BUFFER_HPP__
+#define __TRIPLE_BUFFER_HPP__
+
+#include <atomic>
+
+// Lock-free single producer / single consumer triple buffer.
+// The writer fills write_buffer() and publish()es it, the reader calls update() to swap in the
+// newest published slot and read()s it. Neither side ever waits on the other.
+template <typename T> class TripleBuffer {
+  public:
+    TripleBuffer() : back_(0), front_(1), middle_(2){};
+
+    // writer side
+    // ------------------------------------------------------------------------
+    T &write_buffer() { return buffers_[back_]; }
+    void publish() { back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // reader side
+    // ------------------------------------------------------------------------
+    bool update() {
+        if (!(middle_.load(std::memory_order_acquire) & FRESH))
+            return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T &read() const { return buffers_[front_]; }
+
+  private:
+    static constexpr int INDEX = 0x3;
+    static constexpr int FRESH = 0x4;
+
+    T buffers_[3];
+
+    int back_;
+    int front_;
+    std::atomic<int> middle_;
+};
+
+#endif